@@ -0,0 +1,79 @@
+/*
+ * Generates `src/cstringr-width.h`, the two level display width lookup table
+ * used by `CSR_display_width`, from the intervals in `wcwidth.c`.  To
+ * regenerate:
+ *
+ *   cc -o wcwidth-table extra/wcwidth-table.c
+ *   ./wcwidth-table > src/cstringr-width.h
+ *
+ * Code points are split into blocks of 256.  The first level maps a block to
+ * one of the distinct leaves, and each leaf packs the widths of its 256 code
+ * points at two bits apiece.  Control characters, which `mk_wcwidth` gives a
+ * width of -1, are recorded with a width of 1 so that for ASCII the display
+ * width is the same as the byte length.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "wcwidth.c"
+
+#define CP_MAX 0x110000
+#define BLOCKS (CP_MAX >> 8)
+#define LEAF_BYTES 64
+
+static unsigned char leaves[BLOCKS][LEAF_BYTES];
+static int index_[BLOCKS];
+
+int main(void) {
+  int n_leaves = 0;
+
+  for(int b = 0; b < BLOCKS; b++) {
+    unsigned char leaf[LEAF_BYTES] = {0};
+    for(int i = 0; i < 256; i++) {
+      int w = mk_wcwidth((wchar_t) ((b << 8) + i));
+      if(w < 0) w = 1;
+      leaf[i >> 2] |= (unsigned char) (w << ((i & 3) * 2));
+    }
+    int j;
+    for(j = 0; j < n_leaves; j++)
+      if(!memcmp(leaves[j], leaf, LEAF_BYTES)) break;
+    if(j == n_leaves) memcpy(leaves[n_leaves++], leaf, LEAF_BYTES);
+    index_[b] = j;
+  }
+  if(n_leaves > 256) {
+    fprintf(stderr, "too many distinct leaves (%d)\n", n_leaves);
+    return 1;
+  }
+  printf(
+    "/*\n"
+    " * Generated by `extra/wcwidth-table.c` from the intervals in\n"
+    " * `extra/wcwidth.c`; do not edit by hand.\n"
+    " */\n\n"
+    "#ifndef _CSTRINGR_WIDTH_H\n"
+    "#define _CSTRINGR_WIDTH_H\n\n"
+    "#define CSR_WIDTH_CP_MAX 0x%X\n\n"
+    "static const unsigned char CSR_width_index[%d] = {\n",
+    CP_MAX, BLOCKS
+  );
+  for(int b = 0; b < BLOCKS; b++)
+    printf(
+      "%s%3d%s", b % 12 ? " " : "  ", index_[b],
+      b == BLOCKS - 1 ? "\n" : (b % 12 == 11 ? ",\n" : ",")
+    );
+  printf("};\n");
+  printf(
+    "static const unsigned char CSR_width_leaf[%d][%d] = {\n",
+    n_leaves, LEAF_BYTES
+  );
+  for(int j = 0; j < n_leaves; j++) {
+    printf("  {\n");
+    for(int i = 0; i < LEAF_BYTES; i++)
+      printf(
+        "%s0x%02X%s", i % 12 ? " " : "    ", leaves[j][i],
+        i == LEAF_BYTES - 1 ? "\n" : (i % 12 == 11 ? ",\n" : ",")
+      );
+    printf("  }%s\n", j == n_leaves - 1 ? "" : ",");
+  }
+  printf("};\n\n#endif\n");
+  return 0;
+}
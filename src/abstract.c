@@ -0,0 +1,379 @@
+/*
+Copyright (C) 2020 Brodie Gaslam
+
+This file is part of "vetr - Trust, but Verify"
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+Go to <https://www.r-project.org/Licenses/GPL-2> for a copy of the license.
+*/
+
+#include "alike.h"
+
+/*
+ * Native implementation of the `abstract` methods for lists, data frames,
+ * arrays, and the default method.
+ *
+ * The R versions built templates through R subsetting, which copies the
+ * attributes and every level of nested lists.  Instead we walk the object
+ * once, create zero length vectors, and share attribute values such as names,
+ * levels, and class with the original.  Lists none of whose elements change
+ * are returned as is.
+ *
+ * Classed elements are dispatched on with a lookup similar to `UseMethod`'s,
+ * in the calling environment and then the registered methods.  Methods other
+ * than the ones above, including user defined ones, are called through the
+ * `abstract` generic as before.  Elements without a class attribute are
+ * always handled natively based on their implicit class.
+ *
+ * Results must be the same as those of the R versions, which is why e.g. one
+ * column data frames abstract to their column as `x[0, ]` drops them.
+ */
+
+#define ALIKEC_ABS_CACHE 8      // classes whose method we remember
+
+enum ALIKEC_abs_mode {
+  ALIKEC_ABS_NONE = -1,   // no method for the class
+  ALIKEC_ABS_R,           // call the generic
+  ALIKEC_ABS_DEFAULT,
+  ALIKEC_ABS_LIST,
+  ALIKEC_ABS_DF,
+  ALIKEC_ABS_ARRAY,
+  ALIKEC_ABS_ENV,
+  ALIKEC_ABS_MODES
+};
+static const char * ALIKEC_abs_names[ALIKEC_ABS_MODES] = {
+  NULL, "default", "list", "data.frame", "array", "environment"
+};
+struct ALIKEC_abs_ctx {
+  SEXP rho;               // where `abstract` was called from
+  SEXP s3_table;          // registered S3 methods, or R_NilValue
+  SEXP generic;           // `abstract`
+  SEXP funs[ALIKEC_ABS_MODES];  // our methods we handle natively
+  SEXP matrix_fun;        // `abstract.matrix`, which is the array method
+  int default_mode;
+
+  SEXP cache_cls[ALIKEC_ABS_CACHE];   // CHARSXP class names
+  int cache_mode[ALIKEC_ABS_CACHE];
+  int cache_n;
+};
+static SEXP ALIKEC_abs_dispatch(SEXP x, struct ALIKEC_abs_ctx * ctx);
+
+/*
+ * Value of `sym` in `env` if it is a function, forcing promises
+ */
+static SEXP ALIKEC_abs_fun_in(SEXP env, SEXP sym) {
+  SEXP val = findVarInFrame3(env, sym, TRUE);
+  if(TYPEOF(val) == PROMSXP) {
+    PROTECT(val);
+    val = eval(val, env);
+    UNPROTECT(1);
+  }
+  return isFunction(val) ? val : R_UnboundValue;
+}
+static int ALIKEC_abs_mode_of(SEXP fun, struct ALIKEC_abs_ctx * ctx) {
+  if(fun == R_UnboundValue) return ALIKEC_ABS_NONE;
+  if(fun == ctx->matrix_fun) return ALIKEC_ABS_ARRAY;
+  for(int i = ALIKEC_ABS_DEFAULT; i < ALIKEC_ABS_MODES; ++i)
+    if(fun == ctx->funs[i]) return i;
+  return ALIKEC_ABS_R;
+}
+/*
+ * How to abstract objects of class `cls`, looking first in the calling
+ * environment and its enclosures up to the global environment, then in the
+ * registered methods, and then in the search path.
+ */
+static int ALIKEC_abs_method(SEXP cls, struct ALIKEC_abs_ctx * ctx) {
+  for(int i = 0; i < ctx->cache_n; ++i)
+    if(ctx->cache_cls[i] == cls) return ctx->cache_mode[i];
+
+  const char * cls_chr = CHAR(cls);
+  char * name = R_alloc(strlen(cls_chr) + 10, sizeof(char));
+  sprintf(name, "abstract.%s", cls_chr);
+  SEXP sym = install(name);
+  SEXP fun = R_UnboundValue, env = ctx->rho;
+
+  for(; env != R_EmptyEnv && fun == R_UnboundValue; env = ENCLOS(env)) {
+    fun = ALIKEC_abs_fun_in(env, sym);
+    if(env == R_GlobalEnv) {
+      env = ENCLOS(env);
+      break;
+  } }
+  if(fun == R_UnboundValue && ctx->s3_table != R_NilValue)
+    fun = ALIKEC_abs_fun_in(ctx->s3_table, sym);
+  for(; env != R_EmptyEnv && fun == R_UnboundValue; env = ENCLOS(env))
+    fun = ALIKEC_abs_fun_in(env, sym);
+
+  int mode = ALIKEC_abs_mode_of(fun, ctx);
+  if(ctx->cache_n < ALIKEC_ABS_CACHE) {
+    ctx->cache_cls[ctx->cache_n] = cls;
+    ctx->cache_mode[ctx->cache_n++] = mode;
+  }
+  return mode;
+}
+static SEXP ALIKEC_abs_generic(SEXP x, struct ALIKEC_abs_ctx * ctx) {
+  int quote = TYPEOF(x) == LANGSXP || TYPEOF(x) == SYMSXP ||
+    TYPEOF(x) == PROMSXP;
+  SEXP arg = PROTECT(quote ? lang2(R_QuoteSymbol, x) : x);
+  SEXP call = PROTECT(lang2(ctx->generic, arg));
+  SEXP res = eval(call, ctx->rho);
+  UNPROTECT(2);
+  return res;
+}
+/*
+ * Evaluate `x[0L]`, or `x[0L, , drop=FALSE]` if `matrix` is TRUE, to
+ * subset objects as `[.data.frame` would
+ */
+static SEXP ALIKEC_abs_subset(SEXP x, int matrix) {
+  SEXP call;
+  if(matrix) {
+    call = PROTECT(
+      lang5(
+        R_BracketSymbol, x, ScalarInteger(0), R_MissingArg,
+        ScalarLogical(0)
+    ) );
+    SET_TAG(CDR(CDDR(CDR(call))), install("drop"));
+  } else {
+    call = PROTECT(lang3(R_BracketSymbol, x, ScalarInteger(0)));
+  }
+  SEXP res = eval(call, R_BaseEnv);
+  UNPROTECT(1);
+  return res;
+}
+/*
+ * Zero length vector of the same type as `x`, with the attributes of `x`
+ * except for `names` which are made zero length; as `length(x) <- 0L`
+ * followed by restoring the other attributes.
+ */
+static SEXP ALIKEC_abs_atomic(SEXP x) {
+  SEXP res = PROTECT(allocVector(TYPEOF(x), 0));
+  for(SEXP attr = ATTRIB(x); attr != R_NilValue; attr = CDR(attr)) {
+    if(TAG(attr) == R_NamesSymbol)
+      setAttrib(res, R_NamesSymbol, allocVector(STRSXP, 0));
+    else setAttrib(res, TAG(attr), CAR(attr));
+  }
+  UNPROTECT(1);
+  return res;
+}
+/*
+ * Zero length vector with all zero dimensions; all other attributes are lost
+ * as they are in the R version.  List arrays are treated the same way: the R
+ * version called `NextMethod()` for them but discarded its value, so the
+ * elements were never abstracted into the result.
+ */
+static SEXP ALIKEC_abs_array(SEXP x) {
+  if(!isVectorAtomic(x) && TYPEOF(x) != VECSXP) return x;
+  SEXP dim = getAttrib(x, R_DimSymbol);
+  if(TYPEOF(dim) != INTSXP) dim = R_NilValue;
+  SEXP res = PROTECT(allocVector(TYPEOF(x), 0));
+  SEXP dim_new = PROTECT(allocVector(INTSXP, xlength(dim)));
+  for(R_xlen_t i = 0; i < XLENGTH(dim_new); ++i) INTEGER(dim_new)[i] = 0;
+  setAttrib(res, R_DimSymbol, dim_new);
+  UNPROTECT(2);
+  return res;
+}
+/*
+ * Abstract each element, only copying the list if one of them changes.  The
+ * copy is shallow, so the attributes and unchanged elements are shared.
+ */
+static SEXP ALIKEC_abs_list(SEXP x, struct ALIKEC_abs_ctx * ctx) {
+  R_CheckStack();
+  SEXP res = x;
+  PROTECT_INDEX ipx;
+  PROTECT_WITH_INDEX(res, &ipx);
+
+  for(R_xlen_t i = 0; i < XLENGTH(x); ++i) {
+    SEXP elt = VECTOR_ELT(x, i);
+    SEXP elt_abs = PROTECT(ALIKEC_abs_dispatch(elt, ctx));
+    if(elt_abs != elt) {
+      if(res == x) REPROTECT(res = shallow_duplicate(x), ipx);
+      SET_VECTOR_ELT(res, i, elt_abs);
+    }
+    UNPROTECT(1);
+  }
+  UNPROTECT(1);
+  return res;
+}
+/*
+ * Abstraction based on implicit class, i.e. ignoring the class attribute
+ */
+static SEXP ALIKEC_abs_implicit(SEXP x, struct ALIKEC_abs_ctx * ctx) {
+  if(IS_S4_OBJECT(x)) return x;
+  switch(TYPEOF(x)) {
+    case LGLSXP:
+    case INTSXP:
+    case REALSXP:
+    case CPLXSXP:
+    case STRSXP:
+    case RAWSXP:
+      if(getAttrib(x, R_DimSymbol) != R_NilValue) return ALIKEC_abs_array(x);
+      return ALIKEC_abs_atomic(x);
+    case VECSXP:
+      if(getAttrib(x, R_DimSymbol) != R_NilValue) return ALIKEC_abs_array(x);
+      return ALIKEC_abs_list(x, ctx);
+    default:
+      return x;
+  }
+}
+/*
+ * Abstract with the class attribute removed, and then restore it
+ */
+static SEXP ALIKEC_abs_default(SEXP x, struct ALIKEC_abs_ctx * ctx) {
+  if(IS_S4_OBJECT(x)) return x;
+  SEXP klass = getAttrib(x, R_ClassSymbol);
+  SEXP res = PROTECT(ALIKEC_abs_implicit(x, ctx));
+  if(klass != R_NilValue && getAttrib(res, R_ClassSymbol) == R_NilValue)
+    setAttrib(res, R_ClassSymbol, klass);
+  UNPROTECT(1);
+  return res;
+}
+static int ALIKEC_abs_is_factor(SEXP x) {
+  SEXP klass = getAttrib(x, R_ClassSymbol);
+  if(TYPEOF(x) != INTSXP || TYPEOF(klass) != STRSXP) return 0;
+  R_xlen_t len = XLENGTH(klass);
+  return (
+    len == 1 && !strcmp(CHAR(STRING_ELT(klass, 0)), "factor")
+  ) || (
+    len == 2 && !strcmp(CHAR(STRING_ELT(klass, 0)), "ordered") &&
+    !strcmp(CHAR(STRING_ELT(klass, 1)), "factor")
+  );
+}
+/*
+ * A zero row data frame column, as `[.data.frame` would produce it.  Plain
+ * vectors and factors are done directly, and everything else via `[`.
+ */
+static SEXP ALIKEC_abs_col(SEXP x) {
+  SEXP dim = getAttrib(x, R_DimSymbol);
+  int factor = 0;
+  if(
+    dim != R_NilValue || !(isVectorAtomic(x) || TYPEOF(x) == VECSXP) ||
+    (OBJECT(x) && !(factor = ALIKEC_abs_is_factor(x)))
+  )
+    return ALIKEC_abs_subset(x, xlength(dim) == 2);
+
+  SEXP res = PROTECT(allocVector(TYPEOF(x), 0));
+  if(getAttrib(x, R_NamesSymbol) != R_NilValue)
+    setAttrib(res, R_NamesSymbol, allocVector(STRSXP, 0));
+  if(factor) {
+    SEXP contrasts = getAttrib(x, install("contrasts"));
+    if(contrasts != R_NilValue)
+      setAttrib(res, install("contrasts"), contrasts);
+    setAttrib(res, R_LevelsSymbol, getAttrib(x, R_LevelsSymbol));
+    setAttrib(res, R_ClassSymbol, getAttrib(x, R_ClassSymbol));
+  }
+  UNPROTECT(1);
+  return res;
+}
+/*
+ * `x[0, ]` for plain data frames; sub-classes may have their own `[` methods
+ * so we let R subset them.
+ */
+static SEXP ALIKEC_abs_df(SEXP x) {
+  SEXP klass = getAttrib(x, R_ClassSymbol);
+  if(
+    TYPEOF(x) != VECSXP || TYPEOF(klass) != STRSXP || XLENGTH(klass) != 1 ||
+    strcmp(CHAR(STRING_ELT(klass, 0)), "data.frame")
+  ) {
+    SEXP call = PROTECT(
+      lang4(R_BracketSymbol, x, ScalarInteger(0), R_MissingArg)
+    );
+    SEXP res = eval(call, R_BaseEnv);
+    UNPROTECT(1);
+    return res;
+  }
+  R_xlen_t cols = XLENGTH(x);
+  if(cols == 1) return ALIKEC_abs_col(VECTOR_ELT(x, 0));
+
+  SEXP res = PROTECT(allocVector(VECSXP, cols));
+  for(R_xlen_t i = 0; i < cols; ++i)
+    SET_VECTOR_ELT(res, i, ALIKEC_abs_col(VECTOR_ELT(x, i)));
+  for(SEXP attr = ATTRIB(x); attr != R_NilValue; attr = CDR(attr)) {
+    if(TAG(attr) == R_RowNamesSymbol)
+      setAttrib(res, R_RowNamesSymbol, allocVector(INTSXP, 0));
+    else setAttrib(res, TAG(attr), CAR(attr));
+  }
+  UNPROTECT(1);
+  return res;
+}
+static SEXP ALIKEC_abs_apply(
+  SEXP x, int mode, struct ALIKEC_abs_ctx * ctx
+) {
+  switch(mode) {
+    case ALIKEC_ABS_DEFAULT: return ALIKEC_abs_default(x, ctx);
+    case ALIKEC_ABS_LIST:
+      return TYPEOF(x) == VECSXP ? ALIKEC_abs_list(x, ctx) : x;
+    case ALIKEC_ABS_DF: return ALIKEC_abs_df(x);
+    case ALIKEC_ABS_ARRAY: return ALIKEC_abs_array(x);
+    case ALIKEC_ABS_ENV: return x;
+    case ALIKEC_ABS_R: return ALIKEC_abs_generic(x, ctx);
+    default:
+      // nocov start
+      error(
+        "Internal Error: unknown abstract mode %d; contact maintainer.", mode
+      );
+      // nocov end
+  }
+  return x;  // nocov
+}
+/*
+ * Equivalent of calling `abstract` on an element
+ */
+static SEXP ALIKEC_abs_dispatch(SEXP x, struct ALIKEC_abs_ctx * ctx) {
+  if(IS_S4_OBJECT(x)) return ALIKEC_abs_generic(x, ctx);
+  SEXP klass = getAttrib(x, R_ClassSymbol);
+  if(klass == R_NilValue) return ALIKEC_abs_implicit(x, ctx);
+
+  int mode = ALIKEC_ABS_NONE;
+  for(R_xlen_t i = 0; i < xlength(klass) && mode == ALIKEC_ABS_NONE; ++i)
+    mode = ALIKEC_abs_method(STRING_ELT(klass, i), ctx);
+  if(mode == ALIKEC_ABS_NONE) mode = ctx->default_mode;
+  if(mode == ALIKEC_ABS_NONE)
+    error("No `abstract` method for class \"%s\".", CHAR(asChar(klass)));
+  return ALIKEC_abs_apply(x, mode, ctx);
+}
+/*
+ * @param x object to abstract
+ * @param method which method `x` was dispatched to
+ * @param rho environment `abstract` was called from
+ */
+SEXP ALIKEC_abstract(SEXP x, SEXP method, SEXP rho) {
+  if(TYPEOF(method) != STRSXP || XLENGTH(method) != 1)
+    error("Argument `method` must be character(1L).");
+  if(TYPEOF(rho) != ENVSXP)
+    error("Argument `rho` must be an environment.");
+
+  struct ALIKEC_abs_ctx ctx = {.rho = rho, .cache_n = 0};
+  SEXP ns = PROTECT(R_FindNamespace(mkString("vetr")));
+  ctx.s3_table = findVarInFrame3(ns, install(".__S3MethodsTable__."), TRUE);
+  if(TYPEOF(ctx.s3_table) != ENVSXP) ctx.s3_table = R_NilValue;
+  ctx.generic = ALIKEC_abs_fun_in(ns, install("abstract"));
+  ctx.matrix_fun = ALIKEC_abs_fun_in(ns, install("abstract.matrix"));
+  if(ctx.generic == R_UnboundValue)
+    error("Internal Error: `abstract` generic not found; contact maintainer.");
+
+  int mode = ALIKEC_ABS_NONE;
+  const char * method_chr = CHAR(STRING_ELT(method, 0));
+  ctx.funs[ALIKEC_ABS_R] = R_UnboundValue;
+  for(int i = ALIKEC_ABS_DEFAULT; i < ALIKEC_ABS_MODES; ++i) {
+    char name[32];
+    snprintf(name, sizeof(name), "abstract.%s", ALIKEC_abs_names[i]);
+    ctx.funs[i] = ALIKEC_abs_fun_in(ns, install(name));
+    if(!strcmp(method_chr, ALIKEC_abs_names[i])) mode = i;
+  }
+  if(mode == ALIKEC_ABS_NONE || mode == ALIKEC_ABS_ENV)
+    error("Argument `method` is not a natively supported method.");
+  SEXP default_chr = PROTECT(mkChar("default"));
+  ctx.default_mode = ALIKEC_abs_method(default_chr, &ctx);
+
+  SEXP res = ALIKEC_abs_apply(x, mode, &ctx);
+  UNPROTECT(2);
+  return res;
+}
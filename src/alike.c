@@ -16,6 +16,7 @@ GNU General Public License for more details.
 Go to <https://www.r-project.org/Licenses/GPL-2> for a copy of the license.
 */
 
+#include <string.h>
 #include "settings.h"
 #include "alike.h"
 
@@ -48,13 +49,15 @@ SEXP ALIKEC_res_strings_to_SEXP(struct ALIKEC_res_strings strings) {
  * Other struct initialization functions, see alike.h for descriptions
  *
  * One question here is whether we should create this object once and then
- * re-use it unless an actual error occurs to avoid the R_alloc calls.
+ * re-use it unless an actual error occurs to avoid the allocations.  For now we
+ * make do with a single allocation from the per-call arena.
  */
-struct ALIKEC_res_strings ALIKEC_res_strings_init() {
+struct ALIKEC_res_strings ALIKEC_res_strings_init(struct VALC_arena * arena) {
   struct ALIKEC_res_strings res;
 
-  res.target = (const char **) R_alloc(5, sizeof(const char *));
-  res.current = (const char **) R_alloc(5, sizeof(const char *));
+  res.target =
+    (const char **) VALC_arena_alloc(arena, 10, sizeof(const char *));
+  res.current = res.target + 5;
 
   res.target[0] = "%s%s%s%s";
   res.target[1] = "";
@@ -74,11 +77,11 @@ struct ALIKEC_res_strings ALIKEC_res_strings_init() {
 
   return res;
 }
-struct ALIKEC_res ALIKEC_res_init() {
+struct ALIKEC_res ALIKEC_res_init(struct VALC_arena * arena) {
   return (struct ALIKEC_res) {
     .success=1,
     .dat=(struct ALIKEC_res_dat) {
-      .strings=ALIKEC_res_strings_init(),
+      .strings=ALIKEC_res_strings_init(arena),
       .rec=ALIKEC_rec_track_init(),
       .df=0,
       .lvl=0
@@ -93,6 +96,132 @@ struct ALIKEC_res ALIKEC_res_init() {
 }
 /*-----------------------------------------------------------------------------\
 \-----------------------------------------------------------------------------*/
+/*
+S4 inheritance with caching
+
+We evaluate `inherits(current, klass)` since `Rf_inherits` doesn't work for S4
+classes.  This involves S4 dispatch so we cache the result keyed on the
+current and target class and package CHARSXPs.  Entries are invalidated if the
+definition of either class in the methods package class table (`.classTable`)
+is no longer the same object, which is what happens when a class is
+(re)defined, or when `setIs` updates the subclass.
+
+The cache is direct mapped so an entry may be evicted by a colliding pair, in
+which case we just evaluate again.  Each entry is a list with the four key
+CHARSXPs (which also keeps them from being collected and the pointers
+re-used), the two class definitions, and the result.
+*/
+#define ALIKEC_S4_CACHE_SIZE 256
+
+static SEXP ALIKEC_s4_cache = NULL;
+static SEXP ALIKEC_s4_class_table = NULL;
+
+static int ALIKEC_s4_inherits_eval(SEXP current, SEXP klass) {
+  // Construct call to `inherits`; we evaluate in base env since class
+  // definitions should still be visible and this way unlikely that
+  // inherits gets overwritten.  Can't use Rf_inherits because that doesn't
+  // work for S4 classes, and we can't figure out a way to access inherits3
+  // from src/main/objects.c directly
+
+  SEXP call = PROTECT(lang3(ALIKEC_SYM_inherits, current, klass));
+  int inherits = asLogical(PROTECT(eval(call, R_BaseEnv)));
+  UNPROTECT(2);
+  return inherits;
+}
+static SEXP ALIKEC_s4_pkg(SEXP klass) {
+  SEXP pkg = getAttrib(klass, ALIKEC_SYM_package);
+  return TYPEOF(pkg) == STRSXP && XLENGTH(pkg) == 1 ?
+    STRING_ELT(pkg, 0) : R_BlankString;
+}
+static SEXP ALIKEC_s4_class_def(SEXP klass_chr) {
+  return findVarInFrame(ALIKEC_s4_class_table, installChar(klass_chr));
+}
+static int ALIKEC_s4_inherits(SEXP current, SEXP klass) {
+  SEXP klass_cur = PROTECT(getAttrib(current, R_ClassSymbol));
+  if(
+    TYPEOF(klass_cur) != STRSXP || XLENGTH(klass_cur) != 1 ||
+    TYPEOF(klass) != STRSXP || XLENGTH(klass) != 1
+  ) {
+    UNPROTECT(1);
+    return ALIKEC_s4_inherits_eval(current, klass);
+  }
+  if(!ALIKEC_s4_class_table) {
+    SEXP methods_ns = PROTECT(R_FindNamespace(mkString("methods")));
+    SEXP class_table =
+      findVarInFrame(methods_ns, install(".classTable"));
+    if(TYPEOF(class_table) != ENVSXP) {
+      // nocov start
+      UNPROTECT(2);
+      return ALIKEC_s4_inherits_eval(current, klass);
+      // nocov end
+    }
+    R_PreserveObject(class_table);
+    ALIKEC_s4_class_table = class_table;
+    ALIKEC_s4_cache = allocVector(VECSXP, ALIKEC_S4_CACHE_SIZE);
+    R_PreserveObject(ALIKEC_s4_cache);
+    UNPROTECT(1);
+  }
+  SEXP keys[4] = {
+    STRING_ELT(klass_cur, 0), ALIKEC_s4_pkg(klass_cur),
+    STRING_ELT(klass, 0), ALIKEC_s4_pkg(klass)
+  };
+  SEXP cur_def = PROTECT(ALIKEC_s4_class_def(keys[0]));
+  SEXP tar_def = PROTECT(ALIKEC_s4_class_def(keys[2]));
+
+  uintptr_t hash = 0;
+  for(int i = 0; i < 4; ++i)
+    hash = hash * 31 + ((uintptr_t) keys[i] >> 3);
+  R_xlen_t slot = (R_xlen_t) (hash % ALIKEC_S4_CACHE_SIZE);
+
+  SEXP entry = VECTOR_ELT(ALIKEC_s4_cache, slot);
+  if(entry != R_NilValue) {
+    SEXP entry_keys = VECTOR_ELT(entry, 0);
+    int match = VECTOR_ELT(entry, 1) == cur_def &&
+      VECTOR_ELT(entry, 2) == tar_def;
+    for(int i = 0; i < 4 && match; ++i)
+      match = STRING_ELT(entry_keys, i) == keys[i];
+    if(match) {
+      UNPROTECT(3);
+      return asLogical(VECTOR_ELT(entry, 3));
+    }
+  }
+  int inherits = ALIKEC_s4_inherits_eval(current, klass);
+
+  entry = PROTECT(allocVector(VECSXP, 4));
+  SEXP entry_keys = PROTECT(allocVector(STRSXP, 4));
+  for(int i = 0; i < 4; ++i) SET_STRING_ELT(entry_keys, i, keys[i]);
+  SET_VECTOR_ELT(entry, 0, entry_keys);
+  SET_VECTOR_ELT(entry, 1, cur_def);
+  SET_VECTOR_ELT(entry, 2, tar_def);
+  SET_VECTOR_ELT(entry, 3, ScalarLogical(inherits));
+  SET_VECTOR_ELT(ALIKEC_s4_cache, slot, entry);
+
+  UNPROTECT(5);
+  return inherits;
+}
+/*
+Number of rows of a data frame.  We read the row names attribute directly as
+`getAttrib` would expand the compact `c(NA, -n)` form into `1:n`.  If there are
+no row names we use the length of the first column if it is atomic, and
+otherwise return -1 as we don't know.
+*/
+static R_xlen_t ALIKEC_df_rows(SEXP x) {
+  for(SEXP attr = ATTRIB(x); attr != R_NilValue; attr = CDR(attr)) {
+    if(TAG(attr) != R_RowNamesSymbol) continue;
+    SEXP row_names = CAR(attr);
+    if(
+      TYPEOF(row_names) == INTSXP && XLENGTH(row_names) == 2 &&
+      INTEGER(row_names)[0] == NA_INTEGER
+    )
+      return (R_xlen_t) abs(INTEGER(row_names)[1]);
+    return xlength(row_names);
+  }
+  if(TYPEOF(x) == VECSXP && XLENGTH(x) && isVectorAtomic(VECTOR_ELT(x, 0)))
+    return XLENGTH(VECTOR_ELT(x, 0));
+  return -1;
+}
+/*-----------------------------------------------------------------------------\
+\-----------------------------------------------------------------------------*/
 
 /*
 Object Check
@@ -113,7 +242,7 @@ struct ALIKEC_res ALIKEC_alike_obj(
   const char * err_tok1, * err_tok2, * msg_tmp;
   err_tok1 = err_tok2 = msg_tmp = "";
 
-  struct ALIKEC_res res = ALIKEC_res_init();
+  struct ALIKEC_res res = ALIKEC_res_init(set.arena);
   res.dat.df = 0;
   res.dat.lvl = 6;
 
@@ -144,21 +273,7 @@ struct ALIKEC_res ALIKEC_alike_obj(
         // nocov end
       }
       const char * klass_c = CHAR(asChar(klass));
-
-      // Construct call to `inherits`; we evaluate in base env since class
-      // definitions should still be visible and this way unlikely that
-      // inherits gets overwritten.  Can't use Rf_inherits because that doesn't
-      // work for S4 classes, and we can't figure out a way to access inherits3
-      // from src/main/objects.c directly
-
-      SEXP t, s;
-      t = s = PROTECT(allocList(3));
-      SET_TYPEOF(s, LANGSXP);
-      SETCAR(t, ALIKEC_SYM_inherits); t = CDR(t);
-      SETCAR(t, current); t = CDR(t);
-      SETCAR(t, klass);
-      int inherits = asLogical(PROTECT(eval(s, R_BaseEnv)));
-      UNPROTECT(2);
+      int inherits = ALIKEC_s4_inherits(current, klass);
 
       if(!inherits) {
         res.success = 0;
@@ -277,11 +392,12 @@ struct ALIKEC_res ALIKEC_alike_obj(
     res.dat.lvl = res_attr.dat.lvl;
 
     if(res.success && !is_lang && !is_fun && tar_type != ENVSXP) {
-      SEXP tar_first_el, cur_first_el;
-      R_xlen_t tar_len, cur_len, tar_first_el_len, cur_first_el_len;
+      R_xlen_t tar_len, cur_len, tar_rows, cur_rows;
       // if attribute error is not class, override with col count error
-      // zero lengths match any length
-      int err_tmp_1 = (res.success || (res.dat.df && res.dat.lvl > 0));
+      // zero lengths match any length, and extra columns are allowed in data
+      // frames with `df.mode == 2`
+      int err_tmp_1 = (res.success || (res.dat.df && res.dat.lvl > 0)) &&
+        !(res.dat.df && set.df_mode == 2);
       int err_tmp_2 = (tar_len = xlength(target)) > 0;
       if(
         err_tmp_1 && err_tmp_2 && tar_len != (cur_len = xlength(current))
@@ -313,21 +429,19 @@ struct ALIKEC_res ALIKEC_alike_obj(
       } else if (
         res.dat.df && res.dat.lvl > 0 && tar_type == VECSXP &&
         XLENGTH(target) && TYPEOF(current) == VECSXP && XLENGTH(current) &&
-        isVectorAtomic((tar_first_el = VECTOR_ELT(target, 0))) &&
-        isVectorAtomic((cur_first_el = VECTOR_ELT(current, 0))) &&
-        (tar_first_el_len = XLENGTH(tar_first_el)) && tar_first_el_len &&
-        tar_first_el_len != (cur_first_el_len = XLENGTH(cur_first_el))
+        (tar_rows = ALIKEC_df_rows(target)) > 0 &&
+        (cur_rows = ALIKEC_df_rows(current)) >= 0 && tar_rows != cur_rows
       ) {
-        // check for row count error, note this isn't a perfect check since we
-        // check the first column only
+        // check for row count error; that the columns of `current` have as
+        // many rows is checked when we recurse (see `ALIKEC_df_check`)
 
         res.success = 0;
         res.dat.strings.tar_pre = "have";
         res.dat.strings.target[0] = "%s row%s";
-        res.dat.strings.target[1] = CSR_len_as_chr(tar_first_el_len);
-        res.dat.strings.target[2] = tar_first_el_len == (R_xlen_t) 1 ? "" : "s";
+        res.dat.strings.target[1] = CSR_len_as_chr(tar_rows);
+        res.dat.strings.target[2] = tar_rows == (R_xlen_t) 1 ? "" : "s";
         res.dat.strings.cur_pre = "has";
-        res.dat.strings.current[1] = CSR_len_as_chr(cur_first_el_len);
+        res.dat.strings.current[1] = CSR_len_as_chr(cur_rows);
     } }
     // If no normal, errors, use the attribute error
 
@@ -385,147 +499,562 @@ Handle recursive types; these include VECSXP, environments, and pair lists.
 NOTE: do not recurse into environments that are part of attributes as otherwise
 this setup may not prevent infinite recursion.
 */
+/*-----------------------------------------------------------------------------\
+\-----------------------------------------------------------------------------*/
+/*
+Structural fast path
+
+Much of what we compare is structurally the same as the template: same types,
+same lengths, and the same attributes, often sharing the very same names and
+class CHARSXPs.  Before the full walk we do a cheap lockstep pass over target
+and current that only checks for that situation.  If it holds the objects are
+necessarily alike and we can skip the full comparison.  Otherwise we record
+the path of child indices to the first pair that failed, and the full
+comparison resumes from there, skipping the earlier siblings along the path as
+the fast pass showed them alike.  This way a mismatch costs one walk of the
+object plus re-checking the nodes along the path, not two walks.
+
+This is deliberately an exact comparison rather than a hash of the structure so
+that we can never accept something the full comparison would reject.  It only
+handles the plain vector types; anything else defers to the full comparison.
+*/
+static int ALIKEC_fast_type(SEXPTYPE type) {
+  switch(type) {
+    case LGLSXP:
+    case INTSXP:
+    case REALSXP:
+    case CPLXSXP:
+    case STRSXP:
+    case RAWSXP:
+    case VECSXP:
+      return 1;
+  }
+  return 0;
+}
+/*
+Attribute values must be the same vector or equal, which we only check for
+atomic vectors with no attributes of their own.
+*/
+static int ALIKEC_fast_attr_val(SEXP tar, SEXP cur) {
+  SEXPTYPE type = TYPEOF(tar);
+  if(tar == cur) return type == NILSXP || ALIKEC_fast_type(type);
+  if(
+    type != TYPEOF(cur) || ATTRIB(tar) != R_NilValue ||
+    ATTRIB(cur) != R_NilValue || XLENGTH(tar) != XLENGTH(cur)
+  )
+    return 0;
+
+  R_xlen_t len = XLENGTH(tar);
+  switch(type) {
+    case STRSXP:
+      for(R_xlen_t i = 0; i < len; ++i)
+        if(STRING_ELT(tar, i) != STRING_ELT(cur, i)) return 0;
+      return 1;
+    case LGLSXP:
+    case INTSXP:
+      return !memcmp(INTEGER(tar), INTEGER(cur), len * sizeof(int));
+    case REALSXP:
+      return !memcmp(REAL(tar), REAL(cur), len * sizeof(double));
+  }
+  return 0;
+}
+static int ALIKEC_fast_attr(SEXP tar, SEXP cur) {
+  if(tar == cur) return 1;
+  for(; tar != R_NilValue; tar = CDR(tar), cur = CDR(cur)) {
+    if(
+      cur == R_NilValue || TAG(tar) != TAG(cur) ||
+      !ALIKEC_fast_attr_val(CAR(tar), CAR(cur))
+    )
+      return 0;
+  }
+  return cur == R_NilValue;
+}
+/*
+Whether a pair of nodes could be certainly alike, without looking at their
+children.  Nested NULLs match anything.
+*/
+static int ALIKEC_fast_node(SEXP tar, SEXP cur, int nested) {
+  if(tar == R_NilValue && nested) return 1;
+
+  SEXPTYPE type = TYPEOF(tar);
+  if(
+    type != TYPEOF(cur) || !ALIKEC_fast_type(type) ||
+    IS_S4_OBJECT(tar) || IS_S4_OBJECT(cur)
+  )
+    return 0;
+
+  R_xlen_t tar_len = XLENGTH(tar);
+  if(tar_len && tar_len != XLENGTH(cur)) return 0;
+  return ALIKEC_fast_attr(ATTRIB(tar), ATTRIB(cur));
+}
+struct ALIKEC_fast_frame {
+  SEXP target, current;
+  R_xlen_t i;
+};
+/*
+Returns 1 if target and current are certainly alike, 0 if we don't know.
+
+On 0, if `path` is not NULL it is set to the index of the child at each level
+of the walk leading to the first pair that failed, so that `path->ind[0]` is
+the index of the child of the root.  `path->len` is 0 if the root failed.
+
+We check the root pair before allocating anything as it is often enough to
+tell the fast path can't apply, e.g. for language objects, environments, or
+objects with mismatching attributes at the top level.
+*/
+static int ALIKEC_alike_fast(
+  SEXP target, SEXP current, struct VALC_settings set,
+  struct ALIKEC_fast_path * path
+) {
+  if(path) *path = (struct ALIKEC_fast_path) {.ind = NULL, .len = 0};
+  if(!ALIKEC_fast_node(target, current, 0)) return 0;
+  if(TYPEOF(target) != VECSXP) return 1;
+
+  size_t n = 0, stack_size = 16;
+  struct ALIKEC_fast_frame * stack = (struct ALIKEC_fast_frame *)
+    VALC_arena_alloc(set.arena, stack_size, sizeof(struct ALIKEC_fast_frame));
+  stack[n++] = (struct ALIKEC_fast_frame) {target, current, -1};
+
+  while(n) {
+    struct ALIKEC_fast_frame * frame = stack + n - 1;
+    if(++frame->i >= XLENGTH(frame->target)) {
+      --n;
+      continue;
+    }
+    SEXP tar = VECTOR_ELT(frame->target, frame->i);
+    SEXP cur = VECTOR_ELT(frame->current, frame->i);
+
+    if(!ALIKEC_fast_node(tar, cur, 1)) {
+      if(path) {
+        path->ind = (R_xlen_t *)
+          VALC_arena_alloc(set.arena, n, sizeof(R_xlen_t));
+        for(size_t k = 0; k < n; ++k) path->ind[k] = stack[k].i;
+        path->len = n;
+      }
+      return 0;
+    }
+    // Zero length lists match any list so there is nothing further to check
+
+    if(TYPEOF(tar) == VECSXP && XLENGTH(tar)) {
+      if(n == stack_size) {
+        size_t stack_size_new = CSR_add_szt(stack_size, stack_size);
+        stack = (struct ALIKEC_fast_frame *) VALC_arena_realloc(
+          set.arena, stack, stack_size_new, stack_size,
+          sizeof(struct ALIKEC_fast_frame)
+        );
+        stack_size = stack_size_new;
+      }
+      stack[n++] = (struct ALIKEC_fast_frame) {tar, cur, -1};
+  } }
+  return 1;
+}
+/*
+External interface to the fast path alone, for testing that it never accepts
+objects the full comparison rejects
+*/
+SEXP ALIKEC_alike_fast_ext(SEXP target, SEXP current) {
+  struct VALC_settings set = VALC_settings_init();
+  return ScalarLogical(ALIKEC_alike_fast(target, current, set, NULL));
+}
+/*
+Push a frame for a recursive object onto the traversal stack, growing the
+stack and the protection list if needed.  Returns the (possibly moved) stack.
+*/
+static struct ALIKEC_rec_frame * ALIKEC_rec_push(
+  struct ALIKEC_rec_frame * stack, size_t * n, size_t * stack_size,
+  SEXP * prot, PROTECT_INDEX ipx_prot, SEXP target, SEXP current,
+  struct VALC_settings set
+) {
+  if(*n == *stack_size) {
+    size_t stack_size_new = CSR_add_szt(*stack_size, *stack_size);
+    if(stack_size_new > R_XLEN_T_MAX / 3)
+      // nocov start
+      error("Internal Error: `alike` stack too deep; contact maintainer.");
+      // nocov end
+    stack = (struct ALIKEC_rec_frame *) VALC_arena_realloc(
+      set.arena, stack, stack_size_new, *stack_size,
+      sizeof(struct ALIKEC_rec_frame)
+    );
+    SEXP prot_new = PROTECT(allocVector(VECSXP, stack_size_new * 3));
+    for(R_xlen_t j = 0; j < (R_xlen_t) (*stack_size * 3); ++j)
+      SET_VECTOR_ELT(prot_new, j, VECTOR_ELT(*prot, j));
+    REPROTECT(*prot = prot_new, ipx_prot);
+    UNPROTECT(1);
+    *stack_size = stack_size_new;
+  }
+  stack[*n] = (struct ALIKEC_rec_frame) {
+    .target = target,
+    .current = current,
+    .names = R_NilValue,
+    .tar_sub = R_NilValue,
+    .cur_sub = R_NilValue,
+    .cur_pos = NULL,
+    .done = NULL,
+    .rows = -1,
+    .i = -1,
+    .len = xlength(target),
+    .type = TYPEOF(target)
+  };
+  ++(*n);
+  return stack;
+}
+/*
+Match the columns of a data frame template to those of `current` by name, for
+the `df.mode` setting, so that we can compare them without reordering
+`current`.
+
+We hash the addresses of the names of `current`, which R caches so that equal
+strings in the same encoding are the same CHARSXP.  Template names that are
+not found that way are compared as translated strings in case the encodings
+differ; this is slow, but only happens for columns that are then missing.
+Duplicated names in `current` match the first such column like `[[` would.
+Template columns with blank or NA names match the column in the same position.
+
+Returns the position in `current` of each template column, -1 if missing, or
+NULL if either object has no names, in which case we match by position.
+*/
+static R_xlen_t * ALIKEC_df_cols(
+  SEXP target, SEXP current, struct VALC_settings set
+) {
+  SEXP tar_names = getAttrib(target, R_NamesSymbol);
+  SEXP cur_names = getAttrib(current, R_NamesSymbol);
+  if(
+    TYPEOF(current) != VECSXP || TYPEOF(tar_names) != STRSXP ||
+    TYPEOF(cur_names) != STRSXP
+  )
+    return NULL;
+
+  R_xlen_t tar_len = XLENGTH(tar_names), cur_len = XLENGTH(cur_names);
+  size_t size = 16;   // must be a power of 2
+  while(size < (size_t) cur_len * 2) size *= 2;
+
+  R_xlen_t * slots =
+    (R_xlen_t *) VALC_arena_alloc(set.arena, size, sizeof(R_xlen_t));
+  R_xlen_t * pos =
+    (R_xlen_t *) VALC_arena_alloc(set.arena, tar_len, sizeof(R_xlen_t));
+  for(size_t k = 0; k < size; ++k) slots[k] = -1;
+
+  for(R_xlen_t j = 0; j < cur_len; ++j) {
+    SEXP name = STRING_ELT(cur_names, j);
+    size_t k = (((uintptr_t) name) >> 4) & (size - 1);
+    while(slots[k] >= 0 && STRING_ELT(cur_names, slots[k]) != name)
+      k = (k + 1) & (size - 1);
+    if(slots[k] < 0) slots[k] = j;
+  }
+  for(R_xlen_t i = 0; i < tar_len; ++i) {
+    SEXP name = STRING_ELT(tar_names, i);
+    if(name == NA_STRING || !CHAR(name)[0]) {
+      pos[i] = i < cur_len ? i : -1;
+      continue;
+    }
+    size_t k = (((uintptr_t) name) >> 4) & (size - 1);
+    while(slots[k] >= 0 && STRING_ELT(cur_names, slots[k]) != name)
+      k = (k + 1) & (size - 1);
+    pos[i] = slots[k];
+
+    if(pos[i] < 0) {
+      const char * name_chr = translateCharUTF8(name);
+      for(R_xlen_t j = 0; j < cur_len; ++j) {
+        SEXP cur_name = STRING_ELT(cur_names, j);
+        if(
+          cur_name != NA_STRING &&
+          !strcmp(name_chr, translateCharUTF8(cur_name))
+        ) {
+          pos[i] = j;
+          break;
+  } } } }
+  return pos;
+}
+/*
+Whether a data frame column has as many elements as the frame has rows; we
+can only tell for atomic columns that are not matrices
+*/
+static int ALIKEC_df_col_rows_ok(SEXP col, R_xlen_t rows) {
+  return rows < 0 || !isVectorAtomic(col) || XLENGTH(col) == rows ||
+    getAttrib(col, R_DimSymbol) != R_NilValue;
+}
+/*
+Single pass over the columns of a data frame pushed on the traversal stack.
+
+Most data frame templates are made of zero length atomic columns without
+attributes, e.g. `data.frame(a=integer(), b=character())`, and comparing those
+with `ALIKEC_alike_obj` reduces to a type comparison since zero length matches
+any length and in `attr.mode == 0` (the only mode we have data frames in)
+attributes of `current` that are not in the template are ignored.  So here we
+check the column row counts and do the type comparison for those columns, and
+mark them as done so we don't go through the full comparison for them.
+
+We stop at the first column that fails, leaving it and the remaining columns
+to the normal traversal so that the first failure reported is the same as it
+would have been without this pass.  The traversal only reports a row count
+failure for a column once it has passed the normal comparison.
+*/
+static void ALIKEC_df_check(
+  struct ALIKEC_rec_frame * frame, struct VALC_settings set
+) {
+  SEXP target = frame->target, current = frame->current;
+  if(TYPEOF(current) != VECSXP || !frame->len) return;
+
+  R_xlen_t cur_len = XLENGTH(current);
+  frame->rows = ALIKEC_df_rows(current);
+  frame->done = (char *) VALC_arena_alloc(set.arena, frame->len, 1);
+  memset(frame->done, 0, frame->len);
+
+  for(R_xlen_t i = 0; i < frame->len; ++i) {
+    R_xlen_t j = frame->cur_pos ? frame->cur_pos[i] : i;
+    if(j < 0 || j >= cur_len) break;
+
+    SEXP tar_col = VECTOR_ELT(target, i);
+    SEXP cur_col = VECTOR_ELT(current, j);
+    if(!ALIKEC_df_col_rows_ok(cur_col, frame->rows)) break;
+    if(
+      !isVectorAtomic(tar_col) || XLENGTH(tar_col) ||
+      ATTRIB(tar_col) != R_NilValue || IS_S4_OBJECT(cur_col)
+    )
+      continue;
+    if(!ALIKEC_type_alike_internal(tar_col, cur_col, set).success) break;
+    frame->done[i] = 1;
+  }
+}
+/*
+Traverse recursive objects.
+
+We use an explicit stack of frames rather than recursing on the C stack so that
+very deeply nested objects do not overflow it.  The general logic is to check
+each object for alikeness with `ALIKEC_alike_obj`; if it fails we stop,
+otherwise if it is a recursive object we push a frame and check each of its
+children in turn, popping the frame once all the children are done.
+
+When we fail, the stack contains the full path to the failure, so we record
+the index of each level from it (see `ALIKEC_rec_ind_stack`).  There are two
+types of failure: the object itself fails the comparison in which case we
+record the index for every frame, or the frame on top of the stack produces
+the failure (e.g. environment missing a variable) in which case we skip the
+top frame as the failure is about the object itself rather than one of its
+children.
+*/
 struct ALIKEC_res ALIKEC_alike_rec(
   SEXP target, SEXP current, struct ALIKEC_rec_track rec,
   struct VALC_settings set
 ) {
-  /*
-  Recurse through various types of recursive structures.
+  VALC_PROF_START(prof_start);
 
-  Side note: probably don't need to generate full error report unless we're on
-  outermost `ALIKEC_alike_internal` call since we don't display the inner
-  reports anyway, so could be a bit more efficient there.
+  // Most of the time objects are structurally identical to the template, so
+  // check for that first before doing the full comparison
 
-  General logic here is to check object for alikeness; if not initialize index
-  and return error structure, if so then recurse using specialized logic for
-  each type of recursive structure.  After recursion, check if recursion
-  failed and if so record current index.  Since this happens at every level of
-  the recursion we can recreate the full index to the location of the error.
-  */
-  void R_CheckUserInterrupt(void);
+  struct ALIKEC_fast_path fast_path;
+  if(ALIKEC_alike_fast(target, current, set, &fast_path)) {
+    VALC_PROF_END(VALC_PROF_ALIKE_REC, prof_start);
+    return ALIKEC_res_init(set.arena);
+  }
+  size_t fast_n = 0;  // frames on the stack that follow `fast_path`
 
-  // normal logic, which will have checked length and attributes, etc.
+  size_t lvl_base = rec.lvl;
+  size_t n = 0, stack_size = 16;
+  struct ALIKEC_rec_frame * stack = (struct ALIKEC_rec_frame *)
+    VALC_arena_alloc(set.arena, stack_size, sizeof(struct ALIKEC_rec_frame));
 
-  struct ALIKEC_res res = ALIKEC_alike_obj(target, current, set);
+  // Protect the names and values we retrieve from environments; three slots
+  // per frame.  Everything else is reachable from the top level objects.
 
-  // Result will contain a SEXP, so generate a protection index for it to
-  // simplify the protectin stack handling
+  PROTECT_INDEX ipx_prot, ipx;
+  SEXP prot = allocVector(VECSXP, stack_size * 3);
+  PROTECT_WITH_INDEX(prot, &ipx_prot);
 
-  PROTECT_INDEX ipx;
+  struct ALIKEC_res res = ALIKEC_res_init(set.arena);
   PROTECT_WITH_INDEX(res.wrap, &ipx);
 
-  // Pass on recursive index data
+  int frame_fail = 0;   // failure produced by frame rather than an object
+  int enter = 1;        // need to check `target` and `current`
 
-  res.dat.rec = rec;
+  while(1) {
+    if(enter) {
+      enter = 0;
 
-  if(!res.success) {
-    res.dat.rec.lvl_max = res.dat.rec.lvl;
-  } else {
-    res.dat.rec = ALIKEC_rec_inc(res.dat.rec);  // Increase recursion level
+      // normal logic, which will have checked length and attributes, etc.
 
-    R_xlen_t tar_len = xlength(target);
-    SEXPTYPE tar_type = TYPEOF(target);
+      res = ALIKEC_alike_obj(target, current, set);
+      REPROTECT(res.wrap, ipx);
+      if(!res.success) break;
 
-    if(tar_type == VECSXP || tar_type == EXPRSXP) {
-      R_xlen_t i;
+      // data frame columns must have as many rows as the frame; checked after
+      // the normal logic so that e.g. type failures are reported first
 
-      for(i = 0; i < tar_len; i++) {
-        // if we're here, there is nothing worth protecting in wrap
-        res = ALIKEC_alike_rec(
-          VECTOR_ELT(target, i), VECTOR_ELT(current, i), res.dat.rec, set
-        );
-        REPROTECT(res.wrap, ipx);
-        if(!res.success) {
-          SEXP vec_names = getAttrib(target, R_NamesSymbol);
-          const char * ind_name;
-          if(
-            vec_names == R_NilValue ||
-            !((ind_name = CHAR(STRING_ELT(vec_names, i))))[0]
-          )
-            res.dat.rec = ALIKEC_rec_ind_num(res.dat.rec, i + 1);
-          else
-            res.dat.rec = ALIKEC_rec_ind_chr(res.dat.rec, ind_name);
-          break;
-        }
+      if(
+        n && stack[n - 1].done &&
+        !ALIKEC_df_col_rows_ok(current, stack[n - 1].rows)
+      ) {
+        REPROTECT(res.wrap = allocVector(VECSXP, 2), ipx);
+        res.success = 0;
+        res.dat.strings.tar_pre = "be";
+        res.dat.strings.target[0] = "%s";
+        res.dat.strings.target[1] = CSR_len_as_chr(stack[n - 1].rows);
+        res.dat.strings.cur_pre = "is";
+        res.dat.strings.current[1] = CSR_len_as_chr(XLENGTH(current));
+        SEXP len_lang = PROTECT(lang2(ALIKEC_SYM_length, R_NilValue));
+        SET_VECTOR_ELT(res.wrap, 0, len_lang);
+        SET_VECTOR_ELT(res.wrap, 1, CDR(len_lang));
+        UNPROTECT(1);
+        break;
       }
-    } else if (tar_type == ENVSXP && !set.in_attr) {
-      // Need to guard against possible circular reference in the environments
-      // Note it is important that we cannot recurse when checking environments
-      // in attributes as othrewise we could get inifinite recursion since
-      // rec tracking is specific to each call to ALIKEC_alike_internal
-
-      if(!res.dat.rec.envs) res.dat.rec.envs =
-        ALIKEC_env_set_create(16, set.env_depth_max);
-
-      int env_stack_status =
-        ALIKEC_env_track(target, res.dat.rec.envs, set.env_depth_max);
-      if(!res.dat.rec.envs->no_rec)
-        res.dat.rec.envs->no_rec = !env_stack_status;
-      if(env_stack_status  < 0 && !set.suppress_warnings) {
-        warning(
-          "`alike` environment stack exhausted at recursion depth %d; %s%s",
-          set.env_depth_max,
-          "unable to recurse any further into environments; see ",
-          "`env.depth.max` parameter for `vetr_settings`."
+      SEXPTYPE tar_type = TYPEOF(target);
+
+      if(
+        tar_type == VECSXP || tar_type == EXPRSXP || tar_type == LISTSXP ||
+        (tar_type == ENVSXP && !set.in_attr)
+      ) {
+        stack = ALIKEC_rec_push(
+          stack, &n, &stack_size, &prot, ipx_prot, target, current, set
         );
-        res.dat.rec.envs->no_rec = 1; // so we only get warning once
+        rec = ALIKEC_rec_inc(rec);  // Increase recursion level
+
+        if(tar_type == VECSXP && res.dat.df) {
+          if(set.df_mode)
+            stack[n - 1].cur_pos = ALIKEC_df_cols(target, current, set);
+          ALIKEC_df_check(stack + n - 1, set);
+        } else if(
+          tar_type == VECSXP && n - 1 < fast_path.len && n - 1 == fast_n &&
+          (n == 1 || stack[n - 2].i == fast_path.ind[n - 2])
+        ) {
+          // Children before the one the fast path failed on are alike, see
+          // `ALIKEC_alike_fast`
+
+          stack[n - 1].i = fast_path.ind[n - 1] - 1;
+          fast_n = n;
+        }
       }
-      if(res.dat.rec.envs->no_rec || target == current) {
-        res.success = 1;
-      } else {
-        if(target == R_GlobalEnv && current != R_GlobalEnv) {
+      if(tar_type == ENVSXP && !set.in_attr) {
+        // Need to guard against possible circular reference in the
+        // environments Note it is important that we cannot recurse when
+        // checking environments in attributes as othrewise we could get
+        // inifinite recursion since rec tracking is specific to each call to
+        // ALIKEC_alike_internal
+
+        if(!rec.envs)
+          rec.envs = ALIKEC_env_set_create(16, set.env_depth_max, set.arena);
+
+        int env_stack_status =
+          ALIKEC_env_track(target, rec.envs, set.env_depth_max);
+        if(!rec.envs->no_rec)
+          rec.envs->no_rec = !env_stack_status;
+        if(env_stack_status  < 0 && !set.suppress_warnings) {
+          warning(
+            "`alike` environment stack exhausted at recursion depth %d; %s%s",
+            set.env_depth_max,
+            "unable to recurse any further into environments; see ",
+            "`env.depth.max` parameter for `vetr_settings`."
+          );
+          rec.envs->no_rec = 1; // so we only get warning once
+        }
+        if(rec.envs->no_rec || target == current) {
+          stack[n - 1].len = 0;   // nothing to check
+        } else if(target == R_GlobalEnv && current != R_GlobalEnv) {
           REPROTECT(res.wrap = allocVector(VECSXP, 2), ipx);
           res.success = 0;
           res.dat.strings.tar_pre = "be";
           res.dat.strings.target[1] = "the global environment";
           res.dat.strings.current[1] = ""; // gcc-10
+          frame_fail = 1;
+          break;
         } else {
-          SEXP tar_names = PROTECT(R_lsInternal(target, TRUE));
-          R_xlen_t tar_name_len = XLENGTH(tar_names), i;
-
-          if(tar_name_len != tar_len) {
+          SEXP tar_names = R_lsInternal(target, TRUE);
+          SET_VECTOR_ELT(prot, (n - 1) * 3, tar_names);
+          if(XLENGTH(tar_names) != stack[n - 1].len) {
             // nocov start
             error(
               "Internal Error: mismatching name-env lengths; contact maintainer"
             );
             // nocov end
           }
-          for(i = 0; i < tar_len; i++) {
-            const char * var_name_chr = CHAR(STRING_ELT(tar_names, i));
-            SEXP var_name = PROTECT(install(var_name_chr));
-            SEXP var_cur_val = PROTECT(findVarInFrame(current, var_name));
-            if(var_cur_val == R_UnboundValue) {
-              REPROTECT(res.wrap = allocVector(VECSXP, 2), ipx);
-              res.success = 0;
-              res.dat.strings.tar_pre = "contain";
-              res.dat.strings.target[0] = "variable `%s`";
-              res.dat.strings.target[1] = var_name_chr;
-              res.dat.strings.current[1] = ""; // gcc-10
-            } else {
-              SEXP var_in_frame = PROTECT(findVarInFrame(target, var_name));
-              res = ALIKEC_alike_rec(
-                var_in_frame, var_cur_val, res.dat.rec, set
-              );
-              REPROTECT(res.wrap, ipx);
-              UNPROTECT(1);
-              if(!res.success) {
-                res.dat.rec = ALIKEC_rec_ind_chr(res.dat.rec, var_name_chr);
-            } }
-            UNPROTECT(2);
-            if(!res.success) break;
-          }
-          UNPROTECT(1);
+          stack[n - 1].names = tar_names;
+      } }
+    }
+    if(!n) break;  // done
+
+    // Move on to next child of the frame on top of the stack, if any
+
+    struct ALIKEC_rec_frame * frame = stack + n - 1;
+    frame->i++;
+
+    if(frame->type == LISTSXP) {
+      if(frame->i) {
+        frame->tar_sub = CDR(frame->tar_sub);
+        frame->cur_sub = CDR(frame->cur_sub);
+      } else {
+        frame->tar_sub = frame->target;
+        frame->cur_sub = frame->current;
+      }
+      if(frame->tar_sub == R_NilValue) frame->len = frame->i;  // done
+      else frame->len = frame->i + 1;
+    }
+    if(frame->i >= frame->len) {
+      // All children checked, pop frame
+
+      SET_VECTOR_ELT(prot, (n - 1) * 3, R_NilValue);
+      SET_VECTOR_ELT(prot, (n - 1) * 3 + 1, R_NilValue);
+      SET_VECTOR_ELT(prot, (n - 1) * 3 + 2, R_NilValue);
+      --n;
+      if(fast_n > n) fast_n = n;
+      rec = ALIKEC_rec_dec(rec); // decrement recursion tracker
+      continue;
+    }
+    R_xlen_t i = frame->i;
+
+    switch(frame->type) {
+      case VECSXP:
+      case EXPRSXP:
+        target = VECTOR_ELT(frame->target, i);
+        if(!frame->cur_pos) {
+          current = VECTOR_ELT(frame->current, i);
+        } else if(frame->cur_pos[i] >= 0) {
+          current = VECTOR_ELT(frame->current, frame->cur_pos[i]);
+        } else {
+          // data frame column matched by name is missing
+
+          SEXP col_name =
+            STRING_ELT(getAttrib(frame->target, R_NamesSymbol), i);
+          REPROTECT(res.wrap = allocVector(VECSXP, 2), ipx);
+          res.success = 0;
+          if(col_name != NA_STRING && CHAR(col_name)[0]) {
+            res.dat.strings.tar_pre = "contain";
+            res.dat.strings.target[0] = "column `%s`";
+            res.dat.strings.target[1] = CHAR(col_name);
+            res.dat.strings.current[1] = ""; // gcc-10
+          } else {
+            res.dat.strings.tar_pre = "have";
+            res.dat.strings.target[0] = "at least %s column%s";
+            res.dat.strings.target[1] = CSR_len_as_chr(i + 1);
+            res.dat.strings.target[2] = i ? "s" : "";
+            res.dat.strings.cur_pre = "has";
+            res.dat.strings.current[1] =
+              CSR_len_as_chr(XLENGTH(frame->current));
+        } }
+        break;
+      case ENVSXP: {
+        const char * var_name_chr = CHAR(STRING_ELT(frame->names, i));
+        SEXP var_name = PROTECT(install(var_name_chr));
+        SEXP var_cur_val = findVarInFrame(frame->current, var_name);
+        SET_VECTOR_ELT(prot, (n - 1) * 3 + 2, var_cur_val);
+        if(var_cur_val == R_UnboundValue) {
+          REPROTECT(res.wrap = allocVector(VECSXP, 2), ipx);
+          res.success = 0;
+          res.dat.strings.tar_pre = "contain";
+          res.dat.strings.target[0] = "variable `%s`";
+          res.dat.strings.target[1] = var_name_chr;
+          res.dat.strings.current[1] = ""; // gcc-10
+        } else {
+          SEXP var_in_frame = findVarInFrame(frame->target, var_name);
+          SET_VECTOR_ELT(prot, (n - 1) * 3 + 1, var_in_frame);
+          target = var_in_frame;
+          current = var_cur_val;
         }
+        UNPROTECT(1);
+        break;
       }
-    } else if (tar_type == LISTSXP) {
-      SEXP tar_sub, cur_sub;
-      R_xlen_t i = 0;
-      for(
-        tar_sub = target, cur_sub = current; tar_sub != R_NilValue;
-        tar_sub = CDR(tar_sub), cur_sub = CDR(cur_sub), i++
-      ) {
+      case LISTSXP: {
         // Check tag names; should be in same order??  Probably
 
+        SEXP tar_sub = frame->tar_sub, cur_sub = frame->cur_sub;
         SEXP tar_tag = TAG(tar_sub);
         SEXP tar_tag_chr = PRINTNAME(tar_tag);
         if(tar_tag != R_NilValue && tar_tag != TAG(cur_sub)) {
@@ -557,22 +1086,46 @@ struct ALIKEC_res ALIKEC_alike_rec(
           SET_VECTOR_ELT(res.wrap, 0, sub_lang);
           SET_VECTOR_ELT(res.wrap, 1, CDR(sub_sub_lang));
           UNPROTECT(3);
-          break;
         } else {
-          res = ALIKEC_alike_rec(CAR(tar_sub), CAR(cur_sub), res.dat.rec, set);
-          REPROTECT(res.wrap, ipx);
-          if(!res.success) {
-            if(tar_tag != R_NilValue)
-              res.dat.rec =
-                ALIKEC_rec_ind_chr(res.dat.rec, CHAR(asChar(tar_tag_chr)));
-            else
-              res.dat.rec =
-                ALIKEC_rec_ind_num(res.dat.rec, i + 1);
-            break;
-    } } } }
-    res.dat.rec = ALIKEC_rec_dec(res.dat.rec); // decrement recursion tracker
+          target = CAR(tar_sub);
+          current = CAR(cur_sub);
+        }
+        break;
+      }
+      default:
+        // nocov start
+        error(
+          "Internal Error: unexpected frame type %s; contact maintainer.",
+          type2char(frame->type)
+        );
+        // nocov end
+    }
+    if(!res.success) {
+      frame_fail = 1;
+      break;
+    }
+    // data frame column already checked, see `ALIKEC_df_check`
+
+    if(frame->done && frame->done[i]) continue;
+    enter = 1;
   }
-  UNPROTECT(1);
+  // Record indices to the failure, which also unwinds the recursion level
+
+  if(!res.success) {
+    size_t n_ind = n - (size_t) frame_fail;
+    if(!frame_fail) rec.lvl_max = lvl_base + n;
+    rec.lvl = lvl_base;
+    rec = ALIKEC_rec_ind_stack(rec, stack, n_ind);
+  } else if(rec.lvl != lvl_base) {
+    // nocov start
+    error(
+      "Internal Error: `alike` recursion level corrupted; contact maintainer."
+    );
+    // nocov end
+  }
+  res.dat.rec = rec;
+  UNPROTECT(2);
+  VALC_PROF_END(VALC_PROF_ALIKE_REC, prof_start);
   return res;
 }
 /*-----------------------------------------------------------------------------\
@@ -591,7 +1144,13 @@ struct ALIKEC_res ALIKEC_alike_internal(
   if(set.attr_mode < 0 || set.attr_mode > 2)
     error("Interal Error: `attr.mode` must be in 0:2");           // nocov
 
-  struct ALIKEC_res res = ALIKEC_res_init();
+  struct ALIKEC_res res = ALIKEC_res_init(set.arena);
+
+  // Only top level comparisons are remembered (see memo.c)
+
+  int memo = set.memo;
+  set.memo = 0;
+  if(memo && ALIKEC_memo_get(target, current, set)) return res;
 
   if(TYPEOF(target) == NILSXP && TYPEOF(current) != NILSXP) {
     // Handle NULL special case at top level
@@ -606,6 +1165,7 @@ struct ALIKEC_res ALIKEC_alike_internal(
 
     res = ALIKEC_alike_rec(target, current, ALIKEC_rec_track_init(), set);
     PROTECT(R_NilValue);  /// stack balance
+    if(memo && res.success) ALIKEC_memo_add(target, current, set);
   }
   UNPROTECT(1);
   return res;
@@ -696,11 +1256,17 @@ SEXP ALIKEC_alike_ext(
     // nocov end
   }
   struct VALC_settings set = VALC_settings_vet(settings, env);
+  struct VALC_arena arena = VALC_arena_init(VALC_ARENA_BLOCK_SIZE);
+  set.arena = &arena;
+  int width_opt = -1;
+  set.width_opt = &width_opt;
+
   struct ALIKEC_res res = ALIKEC_alike_internal(target, current, set);
   PROTECT(res.wrap);
   SEXP res_sxp;
   if(res.success) res_sxp = PROTECT(ScalarLogical(1));
   else res_sxp = PROTECT(ALIKEC_res_as_string(res, curr_sub, set));
+  VALC_arena_close(&arena);
   UNPROTECT(2);
   return res_sxp;
 }
@@ -19,6 +19,8 @@ Go to <https://www.r-project.org/Licenses/GPL-2> for a copy of the license.
 #include "cstringr.h"
 #include "pfhash.h"
 #include "settings.h"
+#include "profile.h"
+#include "sample.h"
 #include <wchar.h>
 
 #ifndef _ALIKEC_H
@@ -75,6 +77,7 @@ Go to <https://www.r-project.org/Licenses/GPL-2> for a copy of the license.
     int stack_size_init;
     int no_rec;       // prevent further recursion into environments
     int debug;
+    struct VALC_arena * arena;  // NULL to use R_alloc
   };
   // track indices of error, this will be allocated with as many items as
   // there are recursion levels.
@@ -86,6 +89,30 @@ Go to <https://www.r-project.org/Licenses/GPL-2> for a copy of the license.
     size_t lvl_max;    // max recursion depth so far
     int gp;            // general purpose flag
   };
+  // A level of the `alike` traversal of recursive objects; we keep an explicit
+  // stack of these instead of recursing on the C stack.  `i` is the index of
+  // the child currently being compared.
+
+  struct ALIKEC_rec_frame {
+    SEXP target;
+    SEXP current;
+    SEXP names;       // ls() of target for environments
+    SEXP tar_sub;     // pairlist node of child for pairlists
+    SEXP cur_sub;
+    R_xlen_t * cur_pos; // position in current of each column, NULL if same
+    char * done;        // data frame columns already checked, or NULL
+    R_xlen_t rows;      // row count of data frames, -1 if unknown
+    R_xlen_t i;
+    R_xlen_t len;
+    SEXPTYPE type;
+  };
+  // Path to the first pair the structural fast path failed on, see
+  // `ALIKEC_alike_fast`
+
+  struct ALIKEC_fast_path {
+    R_xlen_t * ind;
+    size_t len;
+  };
   struct ALIKEC_res_dat {
     struct ALIKEC_rec_track rec;
     struct ALIKEC_res_strings strings;
@@ -144,12 +171,18 @@ Go to <https://www.r-project.org/Licenses/GPL-2> for a copy of the license.
   struct ALIKEC_res ALIKEC_alike_internal(
     SEXP target, SEXP current, struct VALC_settings set
   );
+  SEXP ALIKEC_alike_fast_ext(SEXP target, SEXP current);
   SEXP ALIKEC_typeof(SEXP object);
   SEXP ALIKEC_type_alike(SEXP target, SEXP current, SEXP call, SEXP mode);
 
   // - Internal Funs ----------------------------------------------------------
 
   SEXPTYPE ALIKEC_typeof_internal(SEXP object);
+  SEXPTYPE ALIKEC_typeof_sample(SEXP object, struct VALC_settings set);
+  int ALIKEC_memo_get(SEXP target, SEXP current, struct VALC_settings set);
+  void ALIKEC_memo_add(SEXP target, SEXP current, struct VALC_settings set);
+  void ALIKEC_memo_unload(void);
+  SEXP ALIKEC_memo_hits_ext(SEXP reset);
   struct ALIKEC_res ALIKEC_type_alike_internal(
     SEXP target, SEXP current, struct VALC_settings set
   );
@@ -193,6 +226,9 @@ Go to <https://www.r-project.org/Licenses/GPL-2> for a copy of the license.
   struct ALIKEC_rec_track ALIKEC_rec_ind_num(
     struct ALIKEC_rec_track res, R_xlen_t ind
   );
+  struct ALIKEC_rec_track ALIKEC_rec_ind_stack(
+    struct ALIKEC_rec_track rec, struct ALIKEC_rec_frame * stack, size_t n
+  );
   const char * ALIKEC_mode_int(SEXP obj);
   SEXP ALIKEC_mode(SEXP obj);
   SEXP ALIKEC_test(SEXP obj);
@@ -211,6 +247,7 @@ Go to <https://www.r-project.org/Licenses/GPL-2> for a copy of the license.
   );
   SEXP ALIKEC_deparse_width(SEXP obj, int width);
   SEXP ALIKEC_deparse(SEXP obj, int width_cutoff);
+  SEXP ALIKEC_deparse_fast(SEXP obj, int width_cutoff);
   const char * ALIKEC_pad(
     SEXP obj, R_xlen_t lines, int pad, struct VALC_settings set
   );
@@ -218,11 +255,15 @@ Go to <https://www.r-project.org/Licenses/GPL-2> for a copy of the license.
   const char * ALIKEC_deparse_chr(
     SEXP obj, int width_cutoff, struct VALC_settings set
   );
+  SEXP ALIKEC_deparse_chr_ext(SEXP obj, SEXP width_cutoff);
+  const char * ALIKEC_deparse_oneline(
+    SEXP obj, size_t max_chars, size_t keep_at_end, struct VALC_settings set
+  );
   SEXP ALIKEC_inject_call(struct ALIKEC_res res, SEXP call);
   SEXP ALIKEC_match_call(SEXP call, SEXP match_call, SEXP env);
   SEXP ALIKEC_findFun(SEXP symbol, SEXP rho);
   SEXP ALIKEC_findFun_ext(SEXP symbol, SEXP rho);
-  struct ALIKEC_res ALIKEC_res_init();
+  struct ALIKEC_res ALIKEC_res_init(struct VALC_arena * arena);
   SEXP ALIKEC_res_as_strsxp(
     struct ALIKEC_res res, SEXP call, struct VALC_settings set
   );
@@ -231,10 +272,11 @@ Go to <https://www.r-project.org/Licenses/GPL-2> for a copy of the license.
   );
   SEXP ALIKEC_class(SEXP obj, SEXP class);
   SEXP ALIKEC_abstract_ts(SEXP x, SEXP what);
+  SEXP ALIKEC_abstract(SEXP x, SEXP method, SEXP rho);
   int ALIKEC_env_track(SEXP env, struct ALIKEC_env_track * envs, int env_limit);
   SEXP ALIKEC_env_track_test(SEXP env, SEXP stack_size_init, SEXP env_limit);
   struct ALIKEC_env_track * ALIKEC_env_set_create(
-    int stack_size_init, int env_limit
+    int stack_size_init, int env_limit, struct VALC_arena * arena
   );
   int ALIKEC_is_keyword(const char *name);
   int ALIKEC_is_valid_name(const char *name);
@@ -34,7 +34,8 @@ static void include_end_err() {
  * See R interface fun for docs
  */
 SEXP VALC_all_bw(
-  SEXP x, SEXP lo, SEXP hi, SEXP na_rm, SEXP include_bounds
+  SEXP x, SEXP lo, SEXP hi, SEXP na_rm, SEXP include_bounds, SEXP sample,
+  SEXP seed
 ) {
   SEXPTYPE x_type = TYPEOF(x), lo_type = TYPEOF(lo), hi_type = TYPEOF(hi);
 
@@ -122,6 +123,35 @@ SEXP VALC_all_bw(
   inc_lo = inc_end_chr[0] == '[';
   inc_hi = inc_end_chr[1] == ']';
 
+  if(
+    (TYPEOF(sample) != INTSXP && TYPEOF(sample) != REALSXP) ||
+    xlength(sample) != 1 || ISNAN(asReal(sample)) || asReal(sample) < 0
+  )
+    error("Argument `sample` must be a positive scalar number or zero.");
+  if(
+    (TYPEOF(seed) != INTSXP && TYPEOF(seed) != REALSXP) ||
+    xlength(seed) != 1 || asInteger(seed) == NA_INTEGER
+  )
+    error("Argument `seed` must be a scalar integer and not NA.");
+
+  // If sampling, check a copy of the sampled elements with the same code as
+  // for full vectors, and translate indices back when reporting failure
+
+  double sample_num = asReal(sample);
+  R_xlen_t x_len_full = xlength(x);
+  int sampled = sample_num > 0 && x_len_full > sample_num && (
+    x_type == REALSXP || x_type == INTSXP || x_type == LGLSXP ||
+    x_type == STRSXP
+  );
+  struct VALC_sample samp;
+  if(sampled) {
+    samp = VALC_sample_init(
+      x_len_full, (R_xlen_t) sample_num, asInteger(seed), NULL
+    );
+    x = VALC_sample_vec(x, samp);
+  }
+  PROTECT(x);
+
   // Need actualy strings to use with CSR_smprintf
 
   char * inc_lo_str = R_alloc(2, sizeof(char));
@@ -765,9 +795,29 @@ SEXP VALC_all_bw(
     char * msg = CSR_smprintf6(
       10000, "`%s` at index %s not in `%s%s,%s%s`",
       msg_val,
-      CSR_len_as_chr(i + 1),
+      CSR_len_as_chr((sampled ? VALC_sample_index(samp, i) : i) + 1),
       inc_lo_str, lo_as_chr, hi_as_chr, inc_hi_str
     );
+    if(sampled)
+      msg = CSR_smprintf3(
+        10000, "%s (checked sample of %s of %s elements)", msg,
+        CSR_len_as_chr(x_len), CSR_len_as_chr(x_len_full)
+      );
+    UNPROTECT(1);
     return mkString(msg);
-  } else return ScalarLogical(1);
+  }
+  UNPROTECT(1);
+  if(sampled) {
+    // Mark success as sampled with the number of elements checked and total
+
+    SEXP res = PROTECT(allocVector(LGLSXP, 1));
+    LOGICAL(res)[0] = 1;
+    SEXP samp_attr = PROTECT(allocVector(REALSXP, 2));
+    REAL(samp_attr)[0] = (double) x_len;
+    REAL(samp_attr)[1] = (double) x_len_full;
+    setAttrib(res, install("sampled"), samp_attr);
+    UNPROTECT(2);
+    return res;
+  }
+  return ScalarLogical(1);
 }
@@ -1,8 +1,12 @@
 #include "cstringr.h"
+#include "sample.h"
 
 #ifndef _ALLBW_H
 #define _ALLBW_H
 
-  SEXP VALC_all_bw(SEXP x, SEXP hi, SEXP lo, SEXP na_rm, SEXP include_bounds);
+  SEXP VALC_all_bw(
+    SEXP x, SEXP hi, SEXP lo, SEXP na_rm, SEXP include_bounds, SEXP sample,
+    SEXP seed
+  );
 
 #endif
@@ -0,0 +1,237 @@
+/*
+Copyright (C) 2020 Brodie Gaslam
+
+This file is part of "vetr - Trust, but Verify"
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+Go to <https://www.r-project.org/Licenses/GPL-2> for a copy of the license.
+*/
+
+#include <stdint.h>
+#include <string.h>
+#include "arena.h"
+
+/*
+ * Bump allocator for the short lived objects we create while vetting.
+ *
+ * Each top level entry point (`VALC_validate`, `VALC_validate_args`,
+ * `ALIKEC_alike_ext`) owns an arena on its stack and threads it through via the
+ * settings struct.  Functions that are called with an arena of NULL (e.g. the
+ * `_ext` testing interfaces that use `VALC_settings_init`) fall back to
+ * `R_alloc`.
+ *
+ * We only guarantee the same alignment `R_alloc` does (see assumptions.c).
+ */
+
+#define VALC_ARENA_ALIGN(x) \
+  (((x) + sizeof(double) - 1) & ~((size_t) sizeof(double) - 1))
+#define VALC_ARENA_HEAD VALC_ARENA_ALIGN(sizeof(struct VALC_arena_block))
+#define VALC_ARENA_DATA(b) ((char *) (b) + VALC_ARENA_HEAD)
+
+// Cumulative counters for profiling.  Allocation counters are updated as
+// memory is handed out so that they include arenas that are never closed
+// because we exited via a long jump, e.g. on an error in a vetting
+// expression, or that are not owned by an entry point, e.g. the key arena of
+// the tracking hash.  `calls` and the maximum are recorded on close.
+
+static double VALC_arena_calls = 0;
+static double VALC_arena_bytes_alloc = 0;
+static double VALC_arena_bytes_block = 0;
+static double VALC_arena_n_alloc = 0;
+static double VALC_arena_n_block = 0;
+static double VALC_arena_bytes_alloc_max = 0;
+
+struct VALC_arena VALC_arena_init(size_t block_size) {
+  if(block_size < 1)
+    error("Internal Error: arena block size < 1; contact maintainer."); // nocov
+
+  return (struct VALC_arena) {
+    .block = NULL,
+    .spare = NULL,
+    .block_size = VALC_ARENA_ALIGN(block_size),
+    .last = NULL,
+    .last_size = 0,
+    .bytes_alloc = 0,
+    .bytes_block = 0,
+    .n_alloc = 0,
+    .n_block = 0
+  };
+}
+/*
+ * Get a block with at least `size` usable bytes, re-using one released by a
+ * reset if possible.
+ */
+static struct VALC_arena_block * VALC_arena_block_new(
+  struct VALC_arena * arena, size_t size
+) {
+  struct VALC_arena_block * block = NULL, * spare_prev = NULL;
+
+  for(block = arena->spare; block; spare_prev = block, block = block->prev) {
+    if(block->size >= size) {
+      if(spare_prev) spare_prev->prev = block->prev;
+      else arena->spare = block->prev;
+      break;
+  } }
+  if(!block) {
+    if(size > SIZE_MAX - VALC_ARENA_HEAD)
+      error("Internal Error: arena block too large; contact maintainer."); // nocov
+
+    block = (struct VALC_arena_block *) R_alloc(VALC_ARENA_HEAD + size, 1);
+    block->size = size;
+    arena->bytes_block += VALC_ARENA_HEAD + size;
+    arena->n_block++;
+    VALC_arena_bytes_block += VALC_ARENA_HEAD + size;
+    VALC_arena_n_block++;
+  }
+  block->used = 0;
+  block->prev = arena->block;
+  arena->block = block;
+  return block;
+}
+/*
+ * Allocate `n` elements of `size` bytes, semantics as with `R_alloc`.
+ */
+void * VALC_arena_alloc(struct VALC_arena * arena, size_t n, size_t size) {
+  if(!arena) return (void *) R_alloc(n, size);
+  if(!n || !size) return NULL;
+  if(n > SIZE_MAX / size)
+    error("Internal Error: arena allocation overflow; contact maintainer."); // nocov
+
+  size_t bytes = VALC_ARENA_ALIGN(n * size);
+  if(bytes < n * size)
+    error("Internal Error: arena allocation overflow; contact maintainer."); // nocov
+
+  struct VALC_arena_block * block = arena->block;
+  if(!block || block->size - block->used < bytes) {
+    block = VALC_arena_block_new(
+      arena, bytes > arena->block_size ? bytes : arena->block_size
+    );
+  }
+  char * res = VALC_ARENA_DATA(block) + block->used;
+  block->used += bytes;
+
+  arena->last = res;
+  arena->last_size = bytes;
+  arena->bytes_alloc += bytes;
+  arena->n_alloc++;
+  VALC_arena_bytes_alloc += bytes;
+  VALC_arena_n_alloc++;
+  return (void *) res;
+}
+/*
+ * Grow an allocation from `n_old` to `n_new` elements.
+ *
+ * If `ptr` is the most recent allocation and there is room left in the block we
+ * extend it in place, otherwise we allocate anew and copy.  In either case the
+ * first `n_old` elements are preserved.
+ */
+void * VALC_arena_realloc(
+  struct VALC_arena * arena, void * ptr, size_t n_new, size_t n_old,
+  size_t size
+) {
+  if(!arena) return (void *) S_realloc((char *) ptr, n_new, n_old, size);
+  if(n_new <= n_old) return ptr;
+  if(n_new > SIZE_MAX / size)
+    error("Internal Error: arena allocation overflow; contact maintainer."); // nocov
+
+  size_t bytes = VALC_ARENA_ALIGN(n_new * size);
+  struct VALC_arena_block * block = arena->block;
+
+  if(
+    ptr && ptr == (void *) arena->last && block &&
+    block->size - (block->used - arena->last_size) >= bytes
+  ) {
+    block->used += bytes - arena->last_size;
+    arena->bytes_alloc += bytes - arena->last_size;
+    VALC_arena_bytes_alloc += bytes - arena->last_size;
+    arena->last_size = bytes;
+    return ptr;
+  }
+  void * res = VALC_arena_alloc(arena, n_new, size);
+  if(ptr && n_old) memcpy(res, ptr, n_old * size);
+  return res;
+}
+/*
+ * Record the current state so that everything allocated after can be released
+ * with `VALC_arena_reset`.  Anything allocated after the mark must not be used
+ * after the reset.
+ */
+struct VALC_arena_mark VALC_arena_get_mark(struct VALC_arena * arena) {
+  return (struct VALC_arena_mark) {
+    .block = arena->block,
+    .used = arena->block ? arena->block->used : 0
+  };
+}
+void VALC_arena_reset(
+  struct VALC_arena * arena, struct VALC_arena_mark mark
+) {
+  // Move the blocks created after the mark to the spare list
+
+  while(arena->block != mark.block) {
+    struct VALC_arena_block * block = arena->block;
+    if(!block)
+      // nocov start
+      error("Internal Error: invalid arena mark; contact maintainer.");
+      // nocov end
+    arena->block = block->prev;
+    block->prev = arena->spare;
+    arena->spare = block;
+  }
+  if(arena->block) {
+    if(arena->block->used < mark.used)
+      error("Internal Error: invalid arena mark; contact maintainer."); // nocov
+    arena->block->used = mark.used;
+  }
+  arena->last = NULL;
+  arena->last_size = 0;
+}
+/*
+ * Called by the entry points when they are done with the arena, including
+ * before signaling a validation failure, to record the call.  Memory is
+ * released by R.
+ */
+void VALC_arena_close(struct VALC_arena * arena) {
+  VALC_arena_calls++;
+  if(arena->bytes_alloc > VALC_arena_bytes_alloc_max)
+    VALC_arena_bytes_alloc_max = arena->bytes_alloc;
+}
+/*
+ * External interface to the counters, if `reset` is TRUE they are zeroed after
+ * being read.
+ */
+SEXP VALC_arena_stats(SEXP reset) {
+  if(TYPEOF(reset) != LGLSXP || XLENGTH(reset) != 1)
+    error("Argument `reset` must be TRUE or FALSE.");
+
+  const char * names[6] = {
+    "calls", "bytes.alloc", "bytes.block", "n.alloc", "n.block",
+    "bytes.alloc.max"
+  };
+  double vals[6] = {
+    VALC_arena_calls, VALC_arena_bytes_alloc, VALC_arena_bytes_block,
+    VALC_arena_n_alloc, VALC_arena_n_block, VALC_arena_bytes_alloc_max
+  };
+  SEXP res = PROTECT(allocVector(REALSXP, 6));
+  SEXP res_names = PROTECT(allocVector(STRSXP, 6));
+  for(int i = 0; i < 6; i++) {
+    REAL(res)[i] = vals[i];
+    SET_STRING_ELT(res_names, i, mkChar(names[i]));
+  }
+  setAttrib(res, R_NamesSymbol, res_names);
+
+  if(asLogical(reset) == 1) {
+    VALC_arena_calls = VALC_arena_bytes_alloc = VALC_arena_bytes_block = 0;
+    VALC_arena_n_alloc = VALC_arena_n_block = VALC_arena_bytes_alloc_max = 0;
+  }
+  UNPROTECT(2);
+  return res;
+}
@@ -0,0 +1,78 @@
+/*
+Copyright (C) 2020 Brodie Gaslam
+
+This file is part of "vetr - Trust, but Verify"
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+Go to <https://www.r-project.org/Licenses/GPL-2> for a copy of the license.
+*/
+
+#include <R.h>
+#include <Rinternals.h>
+
+#ifndef _VETR_ARENA_H
+#define _VETR_ARENA_H
+
+  // Default usable size of an arena block.  Requests larger than this get a
+  // block of their own.
+
+  #define VALC_ARENA_BLOCK_SIZE 8192
+
+  /*
+   * Blocks are themselves allocated with `R_alloc`, so they share the lifetime
+   * of all our other allocations and are released by R when `.Call` returns,
+   * including when we exit via a long jump.  The arena only reduces the
+   * number of allocations and avoids the copying `S_realloc` does.
+   */
+  struct VALC_arena_block {
+    struct VALC_arena_block * prev;
+    size_t size;     // usable bytes in the block
+    size_t used;     // bytes handed out so far
+  };
+  struct VALC_arena {
+    struct VALC_arena_block * block;   // block we are currently bumping
+    struct VALC_arena_block * spare;   // blocks freed by a reset, for re-use
+    size_t block_size;
+
+    // Last allocation, so that it can be grown in place
+
+    char * last;
+    size_t last_size;
+
+    // Counters for profiling; these are cumulative and not affected by resets
+
+    size_t bytes_alloc;     // bytes handed out
+    size_t bytes_block;     // bytes requested from R for blocks
+    size_t n_alloc;
+    size_t n_block;
+  };
+  // Used to restore an arena to an earlier state
+
+  struct VALC_arena_mark {
+    struct VALC_arena_block * block;
+    size_t used;
+  };
+
+  struct VALC_arena VALC_arena_init(size_t block_size);
+  void * VALC_arena_alloc(struct VALC_arena * arena, size_t n, size_t size);
+  void * VALC_arena_realloc(
+    struct VALC_arena * arena, void * ptr, size_t n_new, size_t n_old,
+    size_t size
+  );
+  struct VALC_arena_mark VALC_arena_get_mark(struct VALC_arena * arena);
+  void VALC_arena_reset(
+    struct VALC_arena * arena, struct VALC_arena_mark mark
+  );
+  void VALC_arena_close(struct VALC_arena * arena);
+  SEXP VALC_arena_stats(SEXP reset);
+
+#endif
@@ -151,7 +151,7 @@ struct ALIKEC_res ALIKEC_alike_attr(
   SEXP target, SEXP current, const char * attr_symb, struct VALC_settings set
 ) {
   struct ALIKEC_res res = ALIKEC_alike_internal(target, current, set);
-  struct ALIKEC_res res_sub = ALIKEC_res_init();
+  struct ALIKEC_res res_sub = ALIKEC_res_init(set.arena);
 
   if(!res.success) {
     res_sub.success = 0;
@@ -188,7 +188,7 @@ struct ALIKEC_res ALIKEC_compare_class(
       is_df = 0, idx_fail = -1;
   const char * cur_class = "<UNINITSTRING>", * cur_class_fail = "";
   const char * tar_class = "<UNINITSTRING>", * tar_class_fail = "";
-  struct ALIKEC_res res = ALIKEC_res_init();
+  struct ALIKEC_res res = ALIKEC_res_init(set.arena);
 
   tar_class_len = XLENGTH(target);
   cur_class_len = XLENGTH(current);
@@ -302,7 +302,7 @@ struct ALIKEC_res ALIKEC_compare_dims(
   R_xlen_t current_len = xlength(current), current_len_cap;
   current_len_cap = current_len > (R_xlen_t) 3 ? (R_xlen_t) 3 : current_len;
 
-  struct ALIKEC_res res = ALIKEC_res_init();
+  struct ALIKEC_res res = ALIKEC_res_init(set.arena);
   const char * class_err_target = "";
   const char * class_err_actual = "";
 
@@ -458,7 +458,7 @@ struct ALIKEC_res ALIKEC_compare_special_char_attrs_internal(
 ) {
   struct ALIKEC_res res = ALIKEC_alike_internal(target, current, set);
   PROTECT(res.wrap);
-  struct ALIKEC_res res_sub = ALIKEC_res_init();
+  struct ALIKEC_res res_sub = ALIKEC_res_init(set.arena);
 
   // Dummy PROTECT since we will protect in only one of the branches and we
   // need this for stack balance (see next UNPROTECT)
@@ -564,7 +564,7 @@ Code here is awful, should just return in one place, not 50...
 struct ALIKEC_res ALIKEC_compare_dimnames(
   SEXP prim, SEXP sec, struct VALC_settings set
 ) {
-  struct ALIKEC_res res = ALIKEC_res_init();
+  struct ALIKEC_res res = ALIKEC_res_init(set.arena);
   if(sec == R_NilValue) {
     res.success = 0;
     res.dat.strings.tar_pre = "have";
@@ -786,7 +786,7 @@ struct ALIKEC_res ALIKEC_compare_ts(
   SEXP target, SEXP current, struct VALC_settings set
 ) {
   SEXPTYPE tar_type = TYPEOF(target), cur_type = TYPEOF(current);
-  struct ALIKEC_res res = ALIKEC_res_init();
+  struct ALIKEC_res res = ALIKEC_res_init(set.arena);
   if(
     tar_type == REALSXP && cur_type == tar_type &&
     XLENGTH(target) == 3 && XLENGTH(current) == 3
@@ -877,7 +877,7 @@ struct ALIKEC_res ALIKEC_compare_attributes_internal_simple(
   tae_val_len = xlength(target);
   cae_val_len = xlength(current);
 
-  struct ALIKEC_res res = ALIKEC_res_init();
+  struct ALIKEC_res res = ALIKEC_res_init(set.arena);
 
   // Start with all cases that don't produce errors
 
@@ -939,7 +939,8 @@ Code originally inspired by `R_compute_identical` (thanks R CORE)
 struct ALIKEC_res ALIKEC_compare_attributes_internal(
   SEXP target, SEXP current, struct VALC_settings set
 ) {
-  struct ALIKEC_res res_attr = ALIKEC_res_init();
+  VALC_PROF_START(prof_start);
+  struct ALIKEC_res res_attr = ALIKEC_res_init(set.arena);
 
   // Note we don't protect these because target and curent should come in
   // protected so every SEXP under them should also be protected
@@ -950,7 +951,10 @@ struct ALIKEC_res ALIKEC_compare_attributes_internal(
   tar_attr = ATTRIB(target);
   cur_attr = ATTRIB(current);
 
-  if(tar_attr == R_NilValue && cur_attr == R_NilValue) return res_attr;
+  if(tar_attr == R_NilValue && cur_attr == R_NilValue) {
+    VALC_PROF_END(VALC_PROF_COMPARE_ATTR, prof_start);
+    return res_attr;
+  }
   /*
   Array to store major errors; to see what each position corresponds to see the
   docs for ALIKEC_res.lvl
@@ -962,9 +966,10 @@ struct ALIKEC_res ALIKEC_compare_attributes_internal(
   stuck recording at least one failure per type of failure.
   */
   struct ALIKEC_res errs[8] = {
-    ALIKEC_res_init(), ALIKEC_res_init(), ALIKEC_res_init(),
-    ALIKEC_res_init(), ALIKEC_res_init(), ALIKEC_res_init(),
-    ALIKEC_res_init(), ALIKEC_res_init()
+    ALIKEC_res_init(set.arena), ALIKEC_res_init(set.arena),
+    ALIKEC_res_init(set.arena), ALIKEC_res_init(set.arena),
+    ALIKEC_res_init(set.arena), ALIKEC_res_init(set.arena),
+    ALIKEC_res_init(set.arena), ALIKEC_res_init(set.arena)
   };
   // store SEXPs in here for protection purposes
 
@@ -1151,6 +1156,12 @@ struct ALIKEC_res ALIKEC_compare_attributes_internal(
       } else if (
         (is_names = !strcmp(tar_tag, "names")) || !strcmp(tar_tag, "row.names")
       ) {
+        // Columns matched by name are checked when we recurse into the data
+        // frame (see `ALIKEC_df_cols`); class is sorted first so `is_df` is
+        // already known
+
+        if(is_names && is_df && set.df_mode) continue;
+
         int err_ind = is_names ? 3 : 4;
         struct ALIKEC_res name_comp =
           ALIKEC_compare_special_char_attrs_internal(
@@ -1242,6 +1253,7 @@ struct ALIKEC_res ALIKEC_compare_attributes_internal(
   } }
   res_attr.dat.df = is_df;
   UNPROTECT(6);
+  VALC_PROF_END(VALC_PROF_COMPARE_ATTR, prof_start);
   return res_attr;
 }
 /*-----------------------------------------------------------------------------\
@@ -0,0 +1,138 @@
+/*
+Copyright (C) 2020 Brodie Gaslam
+
+This file is part of "vetr - Trust, but Verify"
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+Go to <https://www.r-project.org/Licenses/GPL-2> for a copy of the license.
+*/
+
+#include "validate.h"
+
+/*
+ * Audit log, used instead of signaling an error when the `audit` setting is
+ * TRUE.
+ *
+ * Failures are recorded in a ring buffer of fixed size that is allocated the
+ * first time it is needed.  We only store the unrendered result of
+ * `VALC_evaluate` along with what is needed to turn it into a message later,
+ * so that recording a failure costs a few pointer writes.  The messages are
+ * only assembled when the log is read, with `VALC_fail_message` exactly as
+ * they would have been had the error been signaled.
+ *
+ * Since the log holds references to the calls and results, these are not
+ * garbage collected until overwritten or the log is reset.
+ */
+
+#define VALC_AUDIT_SIZE 256
+
+static SEXP VALC_audit_calls = NULL;   // call to report the error against
+static SEXP VALC_audit_args = NULL;    // argument tag
+static SEXP VALC_audit_res = NULL;     // failure from `VALC_evaluate`
+static SEXP VALC_audit_sets = NULL;    // settings list, or NULL
+static int VALC_audit_mode[VALC_AUDIT_SIZE];  // `ret_mode` for message
+static double VALC_audit_seq[VALC_AUDIT_SIZE];
+static double VALC_audit_n = 0;        // total failures recorded
+
+static void VALC_audit_init(void) {
+  VALC_audit_calls = allocVector(VECSXP, VALC_AUDIT_SIZE);
+  R_PreserveObject(VALC_audit_calls);
+  VALC_audit_args = allocVector(VECSXP, VALC_AUDIT_SIZE);
+  R_PreserveObject(VALC_audit_args);
+  VALC_audit_res = allocVector(VECSXP, VALC_AUDIT_SIZE);
+  R_PreserveObject(VALC_audit_res);
+  VALC_audit_sets = allocVector(VECSXP, VALC_AUDIT_SIZE);
+  R_PreserveObject(VALC_audit_sets);
+}
+/*
+ * Record a failure; arguments are as for `VALC_process_error`, except
+ * `settings` is the settings list as provided by the user since the
+ * `VALC_settings` struct does not outlive the call.
+ */
+void VALC_audit_add(
+  SEXP val_res, SEXP val_tag, SEXP fun_call, int ret_mode, SEXP settings
+) {
+  if(!VALC_audit_calls) VALC_audit_init();
+
+  R_xlen_t i = (R_xlen_t) fmod(VALC_audit_n, VALC_AUDIT_SIZE);
+  SET_VECTOR_ELT(VALC_audit_calls, i, fun_call);
+  SET_VECTOR_ELT(VALC_audit_args, i, val_tag);
+  SET_VECTOR_ELT(VALC_audit_res, i, val_res);
+  SET_VECTOR_ELT(VALC_audit_sets, i, settings);
+  VALC_audit_mode[i] = ret_mode;
+  VALC_audit_seq[i] = ++VALC_audit_n;
+}
+/*
+ * External interface to the audit log, oldest entry first.  If `reset` is
+ * TRUE the log is cleared after being read.
+ *
+ * @return a list with the sequence number of each failure, the call and
+ *   argument it was for, the error message, and the total number of failures
+ *   recorded, including those that have been overwritten.
+ */
+SEXP VALC_audit(SEXP reset) {
+  if(TYPEOF(reset) != LGLSXP || XLENGTH(reset) != 1)
+    error("Argument `reset` must be TRUE or FALSE.");
+
+  int n =
+    VALC_audit_n < VALC_AUDIT_SIZE ? (int) VALC_audit_n : VALC_AUDIT_SIZE;
+  R_xlen_t first = (R_xlen_t) fmod(VALC_audit_n - n, VALC_AUDIT_SIZE);
+
+  const char * names[5] = {"seq", "call", "arg", "message", "total"};
+  SEXP res = PROTECT(allocVector(VECSXP, 5));
+  SEXP res_names = PROTECT(allocVector(STRSXP, 5));
+  for(int i = 0; i < 5; i++) SET_STRING_ELT(res_names, i, mkChar(names[i]));
+  setAttrib(res, R_NamesSymbol, res_names);
+  SET_VECTOR_ELT(res, 0, allocVector(REALSXP, n));
+  SET_VECTOR_ELT(res, 1, allocVector(VECSXP, n));
+  SET_VECTOR_ELT(res, 2, allocVector(STRSXP, n));
+  SET_VECTOR_ELT(res, 3, allocVector(STRSXP, n));
+  SET_VECTOR_ELT(res, 4, ScalarReal(VALC_audit_n));
+
+  struct VALC_arena arena = VALC_arena_init(VALC_ARENA_BLOCK_SIZE);
+  for(int j = 0; j < n; j++) {
+    R_xlen_t i = (first + j) % VALC_AUDIT_SIZE;
+    struct VALC_arena_mark mark = VALC_arena_get_mark(&arena);
+    struct VALC_settings set =
+      VALC_settings_vet(VECTOR_ELT(VALC_audit_sets, i), R_BaseEnv);
+    set.arena = &arena;
+    int width_opt = -1;
+    set.width_opt = &width_opt;
+
+    SEXP tag = VECTOR_ELT(VALC_audit_args, i);
+    SEXP msg = PROTECT(
+      VALC_fail_message(
+        VECTOR_ELT(VALC_audit_res, i), tag, VECTOR_ELT(VALC_audit_calls, i),
+        VALC_audit_mode[i], set
+    ) );
+
+    REAL(VECTOR_ELT(res, 0))[j] = VALC_audit_seq[i];
+    SET_VECTOR_ELT(VECTOR_ELT(res, 1), j, VECTOR_ELT(VALC_audit_calls, i));
+    SET_STRING_ELT(VECTOR_ELT(res, 2), j, PRINTNAME(tag));
+    SET_STRING_ELT(VECTOR_ELT(res, 3), j, STRING_ELT(msg, 0));
+    UNPROTECT(1);
+    VALC_arena_reset(&arena, mark);
+  }
+  VALC_arena_close(&arena);
+
+  if(asLogical(reset) == 1 && VALC_audit_calls) {
+    for(int i = 0; i < VALC_AUDIT_SIZE; i++) {
+      SET_VECTOR_ELT(VALC_audit_calls, i, R_NilValue);
+      SET_VECTOR_ELT(VALC_audit_args, i, R_NilValue);
+      SET_VECTOR_ELT(VALC_audit_res, i, R_NilValue);
+      SET_VECTOR_ELT(VALC_audit_sets, i, R_NilValue);
+    }
+    VALC_audit_n = 0;
+  }
+  UNPROTECT(2);
+  return res;
+}
@@ -0,0 +1,56 @@
+/*
+Copyright (C) 2020 Brodie Gaslam
+
+This file is part of "vetr - Trust, but Verify"
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+Go to <https://www.r-project.org/Licenses/GPL-2> for a copy of the license.
+*/
+
+#include "validate.h"
+
+/*
+ * Evaluate `expr` in `rho` `warmup` times untimed, and then `times` times,
+ * timing each evaluation separately.
+ *
+ * @return numeric vector of length `times` with the elapsed seconds of each
+ *   evaluation; timer overhead is not removed, measure it by passing NULL as
+ *   `expr`.
+ */
+SEXP VALC_bench_time(SEXP expr, SEXP rho, SEXP times, SEXP warmup) {
+  if(TYPEOF(rho) != ENVSXP)
+    error("Argument `rho` must be an environment.");
+  if(TYPEOF(times) != INTSXP || XLENGTH(times) != 1 || asInteger(times) < 1)
+    error("Argument `times` must be a positive integer(1L).");
+  if(
+    TYPEOF(warmup) != INTSXP || XLENGTH(warmup) != 1 ||
+    asInteger(warmup) == NA_INTEGER || asInteger(warmup) < 0
+  )
+    error("Argument `warmup` must be a non-negative integer(1L).");
+
+  int times_int = asInteger(times), warmup_int = asInteger(warmup);
+  SEXP res = PROTECT(allocVector(REALSXP, times_int));
+  double * res_dbl = REAL(res);
+
+  for(int i = 0; i < warmup_int; ++i) {
+    if(!(i % 1024)) R_CheckUserInterrupt();
+    eval(expr, rho);
+  }
+  for(int i = 0; i < times_int; ++i) {
+    if(!(i % 1024)) R_CheckUserInterrupt();
+    uint64_t start = VALC_clock_ns();
+    eval(expr, rho);
+    res_dbl[i] = (double) (VALC_clock_ns() - start) * 1e-9;
+  }
+  UNPROTECT(1);
+  return res;
+}
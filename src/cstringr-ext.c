@@ -113,3 +113,48 @@ SEXP CSR_bullet_ext(SEXP str, SEXP bullet, SEXP ctd, SEXP maxlen) {
   return res;
 }
 
+/*
+ * Exercise the string builder: bullet each element of `str` separated by
+ * `sep`, followed by a formatted count and then `str` joined by `sep`.
+ *
+ * `block_size` sets the arena block size, or uses `R_alloc` if zero.  Small
+ * blocks force the buffer onto new blocks, and we make an unrelated arena
+ * allocation after each element so the buffer cannot always grow in place.
+ */
+SEXP CSR_strbuf_ext(
+  SEXP str, SEXP bullet, SEXP ctd, SEXP sep, SEXP maxlen, SEXP block_size
+) {
+  if(
+    TYPEOF(str) != STRSXP || TYPEOF(bullet) != STRSXP ||
+    TYPEOF(ctd) != STRSXP || TYPEOF(sep) != STRSXP
+  )
+    error("First four arguments must be string");
+  is_scalar_pos_int(maxlen);
+  if(
+    TYPEOF(block_size) != INTSXP || XLENGTH(block_size) != 1 ||
+    asInteger(block_size) < 0
+  )
+    error("Argument `block_size` must be a positive scalar integer");
+
+  struct VALC_arena arena_dat;
+  struct VALC_arena * arena = NULL;
+  if(asInteger(block_size)) {
+    arena_dat = VALC_arena_init((size_t) asInteger(block_size));
+    arena = &arena_dat;
+  }
+  const char * sep_chr = CHAR(asChar(sep));
+  struct CSR_strbuf buf = CSR_strbuf_init((size_t) asInteger(maxlen), arena);
+
+  R_xlen_t str_len = XLENGTH(str);
+  for(R_xlen_t i = 0; i < str_len; ++i) {
+    if(i) CSR_strbuf_add(&buf, sep_chr);
+    CSR_strbuf_add_bullet(
+      &buf, CHAR(STRING_ELT(str, i)), CHAR(asChar(bullet)),
+      CHAR(asChar(ctd))
+    );
+    VALC_arena_alloc(arena, 1, sizeof(char));
+  }
+  CSR_strbuf_addf(&buf, " [%.0f] ", (double) str_len);
+  CSR_strbuf_add_joined(&buf, str, sep_chr);
+  return mkString(buf.str);
+}
@@ -208,8 +208,12 @@ encoded strings.
 
 Note, final string size could be up to maxlen + 1 including the NULL terminator.
 A NULL terminator is always added at the end of the string.
+
+`CSR_strmcpy_arena` allocates from `arena` (or with `R_alloc` if it is NULL).
 */
-char * CSR_strmcpy_int(const char * str, size_t maxlen, int warn) {
+char * CSR_strmcpy_arena(
+  const char * str, size_t maxlen, int warn, struct VALC_arena * arena
+) {
   if(!maxlen) return("");
   if(maxlen == SIZE_MAX)
     error("Argument `maxlen` must be at least one smaller than SIZE_MAX.");
@@ -218,7 +222,7 @@ char * CSR_strmcpy_int(const char * str, size_t maxlen, int warn) {
   if(warn && len == maxlen && str[len])
     warning("CSR_strmcpy: truncated string longer than %d", maxlen);
 
-  char * str_new = R_alloc(len + 1, sizeof(char));
+  char * str_new = VALC_arena_alloc(arena, len + 1, sizeof(char));
 
   // should we use memcpy?
   if(!strncpy(str_new, str, len)) {
@@ -238,6 +242,9 @@ char * CSR_strmcpy_int(const char * str, size_t maxlen, int warn) {
 
   return str_new;
 }
+char * CSR_strmcpy_int(const char * str, size_t maxlen, int warn) {
+  return CSR_strmcpy_arena(str, maxlen, warn, NULL);
+}
 char * CSR_strmcpy(const char * str, size_t maxlen) {
   return CSR_strmcpy_int(str, maxlen, 1);
 }
@@ -505,3 +512,123 @@ char * CSR_collapse(SEXP str, const char * sep, size_t max_len) {
 SEXP CSR_collapse_ext(SEXP str, SEXP sep, SEXP max_len) {
   return mkString(CSR_collapse(str, CHAR(asChar(sep)), INTEGER(max_len)[0]));
 }
+/*
+ * Growable string builder
+ *
+ * Messages used to be assembled by chaining `CSR_smprintf*`, `CSR_bullet`,
+ * and `CSR_collapse`, each of which measures its inputs, allocates, and copies
+ * them, so by the time a message was complete it had been copied many times
+ * over.  Instead we now append to a single buffer allocated from the call
+ * arena (or with `R_alloc` if it is NULL), which in the common case grows in
+ * place.
+ *
+ * `maxlen` (normally `nchar.max`) applies to the final string: anything past
+ * it is dropped, with a single warning.  The buffer is always NULL terminated
+ * so `buf.str` can be used directly.
+ */
+struct CSR_strbuf CSR_strbuf_init(size_t maxlen, struct VALC_arena * arena) {
+  if(maxlen == SIZE_MAX)
+    error("Argument `maxlen` must be at least one smaller than SIZE_MAX.");
+  return (struct CSR_strbuf) {
+    .str = "", .len = 0, .size = 0, .maxlen = maxlen, .truncated = 0,
+    .arena = arena
+  };
+}
+/*
+ * Make room for `n` more bytes plus the terminator, and return how many of the
+ * `n` bytes can actually be added without exceeding `maxlen`.
+ */
+static size_t CSR_strbuf_reserve(struct CSR_strbuf * buf, size_t n) {
+  size_t avail = buf->maxlen - buf->len;
+  if(n > avail) {
+    if(!buf->truncated)
+      warning(
+        "CSR_strbuf: truncated string longer than %.0f", (double) buf->maxlen
+      );
+    buf->truncated = 1;
+    n = avail;
+  }
+  size_t size_req = CSR_add_szt(CSR_add_szt(buf->len, n), 1);
+  if(size_req > buf->size) {
+    size_t size_new = buf->size > 64 ? CSR_add_szt(buf->size, buf->size) : 128;
+    if(size_new < size_req) size_new = size_req;
+    if(size_new > buf->maxlen + 1) size_new = buf->maxlen + 1;
+    char * str_new = VALC_arena_realloc(
+      buf->arena, buf->size ? buf->str : NULL, size_new, buf->size,
+      sizeof(char)
+    );
+    if(!buf->size) str_new[0] = '\0';
+    buf->str = str_new;
+    buf->size = size_new;
+  }
+  return n;
+}
+static void CSR_strbuf_addn(
+  struct CSR_strbuf * buf, const char * str, size_t n
+) {
+  if(!n) return;
+  n = CSR_strbuf_reserve(buf, n);
+  memcpy(buf->str + buf->len, str, n);
+  buf->len += n;
+  buf->str[buf->len] = '\0';
+}
+void CSR_strbuf_add(struct CSR_strbuf * buf, const char * str) {
+  CSR_strbuf_addn(buf, str, strlen(str));
+}
+/*
+ * Append using a `printf` style format.  None of the arguments may point into
+ * the buffer itself.
+ */
+void CSR_strbuf_addf(struct CSR_strbuf * buf, const char * format, ...) {
+  va_list args, args_cpy;
+  va_start(args, format);
+  va_copy(args_cpy, args);
+  int len = vsnprintf(NULL, 0, format, args_cpy);
+  va_end(args_cpy);
+  if(len < 0) {
+    // nocov start
+    va_end(args);
+    error("Internal Error: failed formatting string; contact maintainer.");
+    // nocov end
+  }
+  if(len) {
+    size_t n = CSR_strbuf_reserve(buf, (size_t) len);
+    vsnprintf(buf->str + buf->len, n + 1, format, args);
+    buf->len += n;
+    buf->str[buf->len] = '\0';
+  }
+  va_end(args);
+}
+/*
+ * Append `str` preceded by `bullet` and with `ctd` added after each newline
+ * that is not the last character, as with `CSR_bullet`.
+ */
+void CSR_strbuf_add_bullet(
+  struct CSR_strbuf * buf, const char * str, const char * bullet,
+  const char * ctd
+) {
+  CSR_strbuf_add(buf, bullet);
+  const char * line = str;
+  for(const char * s = str; *s; ++s) {
+    if(*s == '\n' && *(s + 1)) {
+      CSR_strbuf_addn(buf, line, (size_t) (s - line) + 1);
+      CSR_strbuf_add(buf, ctd);
+      line = s + 1;
+  } }
+  CSR_strbuf_add(buf, line);
+}
+/*
+ * Append the elements of the character vector `str` separated by `sep`, as
+ * with `CSR_collapse`.
+ */
+void CSR_strbuf_add_joined(
+  struct CSR_strbuf * buf, SEXP str, const char * sep
+) {
+  if(TYPEOF(str) != STRSXP) error("Argument `str` must be a character vector");
+
+  R_xlen_t str_len = XLENGTH(str);
+  for(R_xlen_t i = 0; i < str_len; ++i) {
+    if(i) CSR_strbuf_add(buf, sep);
+    CSR_strbuf_add(buf, CHAR(STRING_ELT(str, i)));
+  }
+}
@@ -20,6 +20,8 @@ Go to <https://www.r-project.org/Licenses/GPL-2> for a copy of the license.
 #include <Rinternals.h>
 #include <stdint.h>
 #include <ctype.h>
+#include <stdarg.h>
+#include "arena.h"
 
 #ifndef _CSTRINGR_H
 #define _CSTRINGR_H
@@ -42,10 +44,15 @@ Go to <https://www.r-project.org/Licenses/GPL-2> for a copy of the license.
   SEXP CSR_lcfirst_ext(SEXP str, SEXP maxlen);
   SEXP CSR_bullet_ext(SEXP str, SEXP bullet, SEXP ctd, SEXP maxlen);
   SEXP CSR_collapse_ext(SEXP str, SEXP sep, SEXP maxlen);
+  SEXP CSR_strbuf_ext(
+    SEXP str, SEXP bullet, SEXP ctd, SEXP sep, SEXP maxlen, SEXP block_size
+  );
 
   SEXP CSR_strsub(SEXP string, SEXP chars, SEXP mark_trunc);
   SEXP CSR_nchar_u(SEXP string);
   SEXP CSR_char_offsets(SEXP string);
+  SEXP CSR_utf8_locale_ext(SEXP loc);
+  SEXP CSR_display_width_ext(SEXP string);
 
   SEXP CSR_test_strmcpy();
   SEXP CSR_test_strappend();
@@ -63,6 +70,9 @@ Go to <https://www.r-project.org/Licenses/GPL-2> for a copy of the license.
   size_t CSR_strmlen(const char * str, size_t maxlen);
   char * CSR_strmcpy(const char * str, size_t maxlen);
   char * CSR_strmcpy_int(const char * str, size_t maxlen, int warn);
+  char * CSR_strmcpy_arena(
+    const char * str, size_t maxlen, int warn, struct VALC_arena * arena
+  );
   char * CSR_smprintf6(
     size_t maxlen, const char * format, const char * a, const char * b,
     const char * c, const char * d, const char * e, const char * f
@@ -94,6 +104,33 @@ Go to <https://www.r-project.org/Licenses/GPL-2> for a copy of the license.
 
   size_t CSR_add_szt(size_t a, size_t b);
 
+  size_t CSR_display_width(const char * str, size_t maxlen, int utf8);
+  size_t CSR_display_fit(
+    const char * str, size_t width, size_t maxlen, int utf8
+  );
+  int CSR_chr_is_utf8(SEXP chr);
+
+  // String builder, `str` is always NULL terminated
+
+  struct CSR_strbuf {
+    char * str;
+    size_t len;       // bytes in `str`, excluding terminator
+    size_t size;      // bytes allocated
+    size_t maxlen;    // max bytes in final string, usually `nchar.max`
+    int truncated;
+    struct VALC_arena * arena;
+  };
+  struct CSR_strbuf CSR_strbuf_init(size_t maxlen, struct VALC_arena * arena);
+  void CSR_strbuf_add(struct CSR_strbuf * buf, const char * str);
+  void CSR_strbuf_addf(struct CSR_strbuf * buf, const char * format, ...);
+  void CSR_strbuf_add_bullet(
+    struct CSR_strbuf * buf, const char * str, const char * bullet,
+    const char * ctd
+  );
+  void CSR_strbuf_add_joined(
+    struct CSR_strbuf * buf, SEXP str, const char * sep
+  );
+
   // macros, offset is expected to be a pointer to a character
 
   #define UTF8_IS_CONT(offset) UTF8_BW(offset, 0x80, 0xBF)
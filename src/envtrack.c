@@ -61,20 +61,15 @@ int ALIKEC_env_stack_alloc(
     }
     if(stack_size > env_limit) return 0;
 
-    SEXP * env_stack_tmp = (SEXP *) R_alloc(stack_size, sizeof(SEXP));
-    envs->stack_size = stack_size;
+    // Copies previous pointers, or grows in place if the stack is the last
+    // thing allocated from the arena
 
-    success = 2;
-    if(envs->env_stack == 0) {
-      envs->env_stack = env_stack_tmp;
-    } else if(envs->stack_size > stack_size_old) {
-      // Prev allocation happened, need to copy pointers
-      for(int i = 0; i < stack_size_old; i++)
-        env_stack_tmp[i] = envs->env_stack[i];
-      // ideally would free env_stack before repointing...
-      envs->env_stack = env_stack_tmp;
-      success = 3;
-    }
+    success = envs->env_stack == 0 ? 2 : 3;
+    envs->env_stack = (SEXP *) VALC_arena_realloc(
+      envs->arena, envs->env_stack, (size_t) stack_size,
+      (size_t) stack_size_old, sizeof(SEXP)
+    );
+    envs->stack_size = stack_size;
   }
   return success;
 }
@@ -82,7 +77,7 @@ int ALIKEC_env_stack_alloc(
 Initialize our stack tracking object
 */
 struct ALIKEC_env_track * ALIKEC_env_set_create(
-  int stack_size_init, int env_limit
+  int stack_size_init, int env_limit, struct VALC_arena * arena
 ) {
   if(stack_size_init < 1) {
     // nocov start
@@ -91,8 +86,9 @@ struct ALIKEC_env_track * ALIKEC_env_set_create(
     );
     // nocov end
   }
-  struct ALIKEC_env_track * envs =
-    (struct ALIKEC_env_track *) R_alloc(1, sizeof(struct ALIKEC_env_track));
+  struct ALIKEC_env_track * envs = (struct ALIKEC_env_track *)
+    VALC_arena_alloc(arena, 1, sizeof(struct ALIKEC_env_track));
+  envs->arena = arena;
   envs->stack_size = envs->stack_ind = 0;
   envs->env_stack = 0;
   envs->no_rec = 0;
@@ -162,7 +158,7 @@ SEXP ALIKEC_env_track_test(SEXP env_list, SEXP stack_size_init, SEXP env_limit)
   }
   int env_limit_int = asInteger(env_limit);
   struct ALIKEC_env_track * envs =
-    ALIKEC_env_set_create(stack_init_int, env_limit_int);
+    ALIKEC_env_set_create(stack_init_int, env_limit_int, NULL);
 
   R_xlen_t len = XLENGTH(env_list);
   SEXP res = PROTECT(allocVector(INTSXP, len));
@@ -18,6 +18,333 @@ Go to <https://www.r-project.org/Licenses/GPL-2> for a copy of the license.
 
 #include "validate.h"
 
+/* -------------------------------------------------------------------------- *\
+\* -------------------------------------------------------------------------- */
+/*
+ * Template dispatch index for long `||` chains of templates.
+ *
+ * If the first template fails, rather than evaluating and comparing each of
+ * the others in turn, we first find which could possibly match `current` based
+ * on their top level type, length, and class, and only try those.  Only if
+ * they all fail do we try the others (which should fail too) so that the error
+ * lists every alternative as it would have without the index.
+ *
+ * The index never evaluates templates, since they may have side effects and
+ * a template after the one that matches would not have been evaluated without
+ * it.  Instead, when templates that are calls to deterministic base
+ * constructors with only constants and other such calls as arguments (e.g.
+ * `matrix(numeric(), 3)`) are evaluated as part of a `||` chain we remember
+ * their top level properties, keyed on the call.  Only the functions in
+ * `VALC_tpl_pure_funs` qualify, as calls to others such as `getOption` or
+ * `sample` may give different results each time, and we check they are not
+ * masked in the evaluation environment since the result would then depend on
+ * more than the call.  Constant templates are their own value.  Other
+ * templates, including symbols, are always tried.
+ */
+
+struct VALC_res_list VALC_evaluate_recurse(
+  SEXP lang, SEXP act_codes, SEXP lang2, SEXP arg_value, SEXP arg_lang,
+  SEXP arg_tag, SEXP lang_full, struct VALC_settings set,
+  struct VALC_res_list res_list, int in_or
+);
+
+#define VALC_OR_INDEX_MIN 4        // min alternatives to use the index
+#define VALC_TPL_CACHE_SIZE 256
+
+struct VALC_tpl_sig {
+  int any;            // could match anything, always try
+  SEXPTYPE type;
+  R_xlen_t len;
+  const char * klass; // last element of class attribute, or NULL
+};
+struct VALC_or_leaf {
+  SEXP lang, act_codes, lang2;
+};
+static SEXP VALC_tpl_cache = NULL;
+
+// Base functions whose result depends only on their arguments
+
+static const char * VALC_tpl_pure_funs[] = {
+  "logical", "integer", "numeric", "double", "complex", "character", "raw",
+  "list", "vector", "c", "rep", "matrix", "array", "factor", "ordered",
+  "data.frame", "structure", "(", "-", "+", ":"
+};
+
+static int VALC_act_mode(SEXP act_codes) {
+  return asInteger(
+    TYPEOF(act_codes) == LISTSXP ? CAR(act_codes) : act_codes
+  );
+}
+/*
+ * Collect the alternatives of a `||` chain, returns the number of
+ * alternatives, or -1 if any of them is not a template.  `leaves` may be NULL
+ * to just count.
+ */
+static int VALC_or_leaves(
+  SEXP lang, SEXP act_codes, SEXP lang2, struct VALC_or_leaf * leaves, int n
+) {
+  int mode = VALC_act_mode(act_codes);
+  if(mode == 2) {
+    lang = CDR(lang);
+    lang2 = CDR(lang2);
+    act_codes = CDR(act_codes);
+    for(int i = 0; i < 2 && n >= 0; ++i) {
+      n = VALC_or_leaves(CAR(lang), CAR(act_codes), CAR(lang2), leaves, n);
+      lang = CDR(lang);
+      lang2 = CDR(lang2);
+      act_codes = CDR(act_codes);
+    }
+    return n;
+  }
+  if(mode != 999) return -1;
+  if(leaves) leaves[n] = (struct VALC_or_leaf) {lang, act_codes, lang2};
+  return n + 1;
+}
+/*
+ * Whether a template is a call to one of `VALC_tpl_pure_funs` with only
+ * constants and other such calls as arguments, and if so accumulate a hash of
+ * it in `hash`.
+ */
+static int VALC_tpl_pure(SEXP lang, SEXP rho, uintptr_t * hash) {
+  switch(TYPEOF(lang)) {
+    case LANGSXP: {
+      SEXP fun = CAR(lang);
+      if(TYPEOF(fun) != SYMSXP) return 0;
+      const char * fun_chr = CHAR(PRINTNAME(fun));
+      size_t funs_n = sizeof(VALC_tpl_pure_funs) / sizeof(const char *), i;
+      for(i = 0; i < funs_n; ++i)
+        if(!strcmp(fun_chr, VALC_tpl_pure_funs[i])) break;
+      if(i == funs_n) return 0;
+      SEXP fun_base = findVarInFrame3(R_BaseEnv, fun, TRUE);
+      if(TYPEOF(fun_base) == PROMSXP) fun_base = eval(fun_base, R_BaseEnv);
+      if(
+        TYPEOF(rho) != ENVSXP || !isFunction(fun_base) ||
+        (rho != R_BaseEnv && findFun(fun, rho) != fun_base)
+      )
+        return 0;
+      *hash = *hash * 31 + (((uintptr_t) fun) >> 4);
+      for(lang = CDR(lang); lang != R_NilValue; lang = CDR(lang)) {
+        *hash = *hash * 31 + (uintptr_t) (TAG(lang) != R_NilValue);
+        if(!VALC_tpl_pure(CAR(lang), rho, hash)) return 0;
+      }
+      return 1;
+    }
+    case SYMSXP:
+      *hash = *hash * 31 + 1;
+      return lang == R_MissingArg;
+    case NILSXP:
+    case LGLSXP:
+    case INTSXP:
+    case REALSXP:
+    case CPLXSXP:
+    case STRSXP:
+      *hash = *hash * 31 + (uintptr_t) TYPEOF(lang) + (uintptr_t) xlength(lang);
+      return 1;
+  }
+  return 0;
+}
+static struct VALC_tpl_sig VALC_tpl_sig_of(
+  SEXP tpl, struct VALC_settings set
+) {
+  struct VALC_tpl_sig sig = {.any = 1, .type = NILSXP, .len = 0, .klass=NULL};
+  SEXPTYPE type = TYPEOF(tpl);
+  if(
+    IS_S4_OBJECT(tpl) || (
+      type != NILSXP && type != VECSXP && !isVectorAtomic(tpl)
+  ) )
+    return sig;
+
+  sig.any = 0;
+  sig.type = type;
+  sig.len = xlength(tpl);
+  SEXP klass = getAttrib(tpl, R_ClassSymbol);
+  if(TYPEOF(klass) == STRSXP && XLENGTH(klass)) {
+    const char * klass_chr = CHAR(STRING_ELT(klass, XLENGTH(klass) - 1));
+    char * klass_cpy = VALC_arena_alloc(set.arena, strlen(klass_chr) + 1, 1);
+    strcpy(klass_cpy, klass_chr);
+    sig.klass = klass_cpy;
+  }
+  return sig;
+}
+/*
+ * Top level properties of a template, without evaluating it.  We only know
+ * them for constants, and for pure calls (see `VALC_tpl_pure`) that were
+ * evaluated before and recorded with `VALC_tpl_sig_set`.  Anything else could
+ * match anything.
+ */
+static struct VALC_tpl_sig VALC_tpl_sig_get(
+  SEXP lang, struct VALC_settings set
+) {
+  struct VALC_tpl_sig sig = {.any = 1, .type = NILSXP, .len = 0, .klass=NULL};
+  if(TYPEOF(lang) == SYMSXP) return sig;
+  if(TYPEOF(lang) != LANGSXP) return VALC_tpl_sig_of(lang, set);
+
+  uintptr_t hash = 0;
+  if(!VALC_tpl_cache || !VALC_tpl_pure(lang, set.env, &hash)) return sig;
+
+  SEXP entry =
+    VECTOR_ELT(VALC_tpl_cache, (R_xlen_t) (hash % VALC_TPL_CACHE_SIZE));
+  if(
+    entry != R_NilValue &&
+    R_compute_identical(lang, VECTOR_ELT(entry, 0), 16)
+  ) {
+    double * props = REAL(VECTOR_ELT(entry, 1));
+    SEXP klass = STRING_ELT(VECTOR_ELT(entry, 2), 0);
+    sig = (struct VALC_tpl_sig) {
+      .any = (int) props[0], .type = (SEXPTYPE) props[1],
+      .len = (R_xlen_t) props[2], .klass = NULL
+    };
+    if(klass != NA_STRING) {
+      char * klass_cpy =
+        VALC_arena_alloc(set.arena, strlen(CHAR(klass)) + 1, 1);
+      strcpy(klass_cpy, CHAR(klass));
+      sig.klass = klass_cpy;
+    }
+  }
+  return sig;
+}
+/*
+ * Record the properties of `tpl`, the result of evaluating the `||`
+ * alternative `lang`, if `lang` is a pure call.
+ */
+static void VALC_tpl_sig_set(SEXP lang, SEXP tpl, struct VALC_settings set) {
+  uintptr_t hash = 0;
+  if(TYPEOF(lang) != LANGSXP || !VALC_tpl_pure(lang, set.env, &hash)) return;
+
+  R_xlen_t slot = (R_xlen_t) (hash % VALC_TPL_CACHE_SIZE);
+  if(!VALC_tpl_cache) {
+    VALC_tpl_cache = allocVector(VECSXP, VALC_TPL_CACHE_SIZE);
+    R_PreserveObject(VALC_tpl_cache);
+  } else {
+    SEXP entry = VECTOR_ELT(VALC_tpl_cache, slot);
+    if(
+      entry != R_NilValue &&
+      R_compute_identical(lang, VECTOR_ELT(entry, 0), 16)
+    )
+      return;
+  }
+  struct VALC_tpl_sig sig = VALC_tpl_sig_of(tpl, set);
+  SEXP entry = PROTECT(allocVector(VECSXP, 3));
+  SET_VECTOR_ELT(entry, 0, duplicate(lang));
+  SEXP props = allocVector(REALSXP, 3);
+  SET_VECTOR_ELT(entry, 1, props);
+  REAL(props)[0] = sig.any;
+  REAL(props)[1] = sig.type;
+  REAL(props)[2] = (double) sig.len;
+  SET_VECTOR_ELT(
+    entry, 2, sig.klass ? mkString(sig.klass) : ScalarString(NA_STRING)
+  );
+  SET_VECTOR_ELT(VALC_tpl_cache, slot, entry);
+  UNPROTECT(1);
+}
+/*
+ * Whether a template with properties `sig` could possibly be alike `current`,
+ * this must never return 0 for a template that would match.
+ */
+static int VALC_tpl_may_match(
+  struct VALC_tpl_sig sig, SEXP current, struct VALC_settings set
+) {
+  if(sig.any || IS_S4_OBJECT(current)) return 1;
+
+  SEXPTYPE cur_type = TYPEOF(current);
+  if(
+    sig.type != cur_type && !(
+      (sig.type == INTSXP || sig.type == REALSXP) &&
+      (cur_type == INTSXP || cur_type == REALSXP)
+  ) )
+    return 0;
+  if(sig.len && sig.len != xlength(current)) return 0;
+  if(sig.klass && !set.attr_mode) {
+    SEXP klass = getAttrib(current, R_ClassSymbol);
+    if(
+      TYPEOF(klass) == STRSXP && XLENGTH(klass) &&
+      strcmp(sig.klass, CHAR(STRING_ELT(klass, XLENGTH(klass) - 1)))
+    )
+      return 0;
+  }
+  return 1;
+}
+/*
+ * Evaluate a `||` chain with the index if it is long enough and only has
+ * templates, otherwise sets `indexed` to 0 and returns `res_list` untouched.
+ *
+ * The first alternative is always tried first, as it would be without the
+ * index, and the index is only built if it fails.
+ */
+static struct VALC_res_list VALC_evaluate_or_index(
+  SEXP lang, SEXP act_codes, SEXP lang2, SEXP arg_value, SEXP arg_lang,
+  SEXP arg_tag, SEXP lang_full, struct VALC_settings set,
+  struct VALC_res_list res_list, int * indexed
+) {
+  *indexed = 0;
+  int n = VALC_or_leaves(lang, act_codes, lang2, NULL, 0);
+  if(n < VALC_OR_INDEX_MIN) return res_list;
+
+  struct VALC_or_leaf * leaves =
+    VALC_arena_alloc(set.arena, (size_t) n, sizeof(struct VALC_or_leaf));
+  VALC_or_leaves(lang, act_codes, lang2, leaves, 0);
+  *indexed = 1;
+
+  int base = res_list.idx;
+  SEXP sxp_base = res_list.list_sxp_tail;
+  res_list = VALC_evaluate_recurse(
+    leaves[0].lang, leaves[0].act_codes, leaves[0].lang2, arg_value,
+    arg_lang, arg_tag, lang_full, set, res_list, 1
+  );
+  if(res_list.list_tpl[res_list.idx - 1].success) return res_list;
+
+  // Try the remaining candidates first, then the rest, recording which leaf
+  // each result is for; each template adds exactly one result.  Templates are
+  // tried in their original order within each pass, so we never evaluate one
+  // that comes after the one that matches.
+
+  int * order = VALC_arena_alloc(set.arena, (size_t) n, sizeof(int));
+  int * cand = VALC_arena_alloc(set.arena, (size_t) n, sizeof(int));
+  for(int i = 1; i < n; ++i)
+    cand[i] = VALC_tpl_may_match(
+      VALC_tpl_sig_get(leaves[i].lang, set), arg_value, set
+    );
+
+  order[0] = 0;
+  int k = 1;
+  for(int pass = 1; pass >= 0; --pass) {
+    for(int i = 1; i < n; ++i) {
+      if(cand[i] != pass) continue;
+      res_list = VALC_evaluate_recurse(
+        leaves[i].lang, leaves[i].act_codes, leaves[i].lang2, arg_value,
+        arg_lang, arg_tag, lang_full, set, res_list, 1
+      );
+      if(res_list.idx != base + k + 1)
+        // nocov start
+        error(
+          "Internal Error: unexpected template result count; %s",
+          "contact maintainer."
+        );
+        // nocov end
+      order[k++] = i;
+      if(res_list.list_tpl[res_list.idx - 1].success) return res_list;
+    }
+  }
+  // Everything failed, put results back in the original order for the error
+
+  struct VALC_res_node * nodes =
+    VALC_arena_alloc(set.arena, (size_t) n, sizeof(struct VALC_res_node));
+  SEXP sxps = PROTECT(allocVector(VECSXP, n));
+  SEXP sxp_node = sxp_base;
+  for(int j = 0; j < n; ++j) {
+    nodes[order[j]] = res_list.list_tpl[base + j];
+    SET_VECTOR_ELT(sxps, order[j], CAR(sxp_node));
+    sxp_node = CDR(sxp_node);
+  }
+  sxp_node = sxp_base;
+  for(int i = 0; i < n; ++i) {
+    res_list.list_tpl[base + i] = nodes[i];
+    SETCAR(sxp_node, VECTOR_ELT(sxps, i));
+    sxp_node = CDR(sxp_node);
+  }
+  UNPROTECT(1);
+  return res_list;
+}
 /* -------------------------------------------------------------------------- *\
 \* -------------------------------------------------------------------------- */
 /*
@@ -38,7 +365,7 @@ Go to <https://www.r-project.org/Licenses/GPL-2> for a copy of the license.
 struct VALC_res_list VALC_evaluate_recurse(
   SEXP lang, SEXP act_codes, SEXP lang2, SEXP arg_value, SEXP arg_lang,
   SEXP arg_tag, SEXP lang_full, struct VALC_settings set,
-  struct VALC_res_list res_list
+  struct VALC_res_list res_list, int in_or
 ) {
   /*
   check act_codes:
@@ -97,6 +424,14 @@ struct VALC_res_list VALC_evaluate_recurse(
   if(mode == 1 || mode == 2) {
     // Dealing with && or ||, so recurse on each element
 
+    if(mode == 2 && !in_or) {
+      int indexed;
+      res_list = VALC_evaluate_or_index(
+        lang, act_codes, lang2, arg_value, arg_lang, arg_tag, lang_full, set,
+        res_list, &indexed
+      );
+      if(indexed) return res_list;
+    }
     if(TYPEOF(lang) == LANGSXP) {
       int parse_count = 0;
       lang = CDR(lang);
@@ -106,7 +441,7 @@ struct VALC_res_list VALC_evaluate_recurse(
       while(lang != R_NilValue) {
         res_list = VALC_evaluate_recurse(
           CAR(lang), CAR(act_codes), CAR(lang2), arg_value, arg_lang, arg_tag,
-          lang_full, set, res_list
+          lang_full, set, res_list, mode == 2
         );
         // recall res_list.idx points to next available slot, not last result
         struct VALC_res_node res_val = res_list.list_tpl[res_list.idx - 1];
@@ -156,7 +491,9 @@ struct VALC_res_list VALC_evaluate_recurse(
     int err_val = 0;
     int eval_res_c = -1000;  // initialize to illegal value
     int * err_point = &err_val;
+    VALC_PROF_START(prof_start);
     eval_tmp = PROTECT(R_tryEval(lang, set.env, err_point));
+    VALC_PROF_END(VALC_PROF_EVAL, prof_start);
 
     SET_VECTOR_ELT(eval_dat, 0, lang2);
     SET_VECTOR_ELT(eval_dat, 1, eval_tmp);
@@ -168,6 +505,10 @@ struct VALC_res_list VALC_evaluate_recurse(
         "Validation expression for argument `%s` produced an error (see previous error)."
       );
     }
+    // Remember what `||` templates look like for the index
+
+    if(mode == 999 && in_or)
+      VALC_tpl_sig_set(lang, VECTOR_ELT(eval_dat, 1), set);
     if(mode == 10) {
       eval_res_c = VALC_all(VECTOR_ELT(eval_dat, 1));
       eval_res.tpl = 0;
@@ -200,6 +541,22 @@ struct VALC_res_list VALC_evaluate_recurse(
 }
 /* -------------------------------------------------------------------------- *\
 \* -------------------------------------------------------------------------- */
+/*
+ * Retrieve the "err.msg" attribute of a standard token, if any
+ */
+static SEXP VALC_error_attrib(SEXP lang, SEXP arg_tag, SEXP sys_call) {
+  SEXP err_attrib = getAttrib(lang, VALC_SYM_errmsg);
+  if(
+    err_attrib != R_NilValue &&
+    (TYPEOF(err_attrib) != STRSXP || XLENGTH(err_attrib) != 1)
+  ) {
+    VALC_arg_error(
+      arg_tag, sys_call,
+      "\"err.msg\" attribute for validation token for argument `%s` must be a one length character vector."
+    );
+  }
+  return err_attrib;
+}
 /*
  * Helper funs to extract errors from eval recurse
  *
@@ -214,27 +571,18 @@ static SEXP VALC_error_standard(
   SEXP eval_tmp = VECTOR_ELT(sxp_dat, 1);
   SEXP err_attrib;
   struct ALIKEC_pad_quote_res err_call;
-  char * err_str;
+  struct CSR_strbuf err_str = CSR_strbuf_init(set.nchar_max, set.arena);
 
   // If message attribute defined, this is easy:
 
-  err_attrib = PROTECT(getAttrib(lang, VALC_SYM_errmsg));
+  err_attrib = PROTECT(VALC_error_attrib(lang, arg_tag, sys_call));
   if(err_attrib != R_NilValue) {
-    if(TYPEOF(err_attrib) != STRSXP || XLENGTH(err_attrib) != 1) {
-      VALC_arg_error(
-        arg_tag, sys_call,
-        "\"err.msg\" attribute for validation token for argument `%s` must be a one length character vector."
-      );
-    }
     err_call = ALIKEC_pad_or_quote(arg_lang, set.width, -1, set);
 
-    // Need to make copy of string, modify it, and turn it back into
-    // string
+    // Substitute the call into the message attribute
 
     const char * err_attrib_msg = CHAR(STRING_ELT(err_attrib, 0));
-    err_str = CSR_smprintf4(
-      set.nchar_max, err_attrib_msg, err_call.chr, "", "", ""
-    );
+    CSR_strbuf_addf(&err_str, err_attrib_msg, err_call.chr, "", "", "");
   } else {
     // message attribute not defined, must construct error message based
     // on result of evaluation
@@ -242,44 +590,45 @@ static SEXP VALC_error_standard(
     err_call = ALIKEC_pad_or_quote(lang, set.width, -1, set);
     int eval_res_c = VALC_all(eval_tmp);
 
-    char * err_tok;
+    const char * err_extra_a = "is not all TRUE";
+    const char * err_extra_b = "is not TRUE";
+    const char * err_extra;
+    if(eval_res_c == 0) {
+      err_extra = err_extra_a;
+    } else {
+      err_extra = err_extra_b;
+    }
+    const char * extra_blank = "";
+    if(!err_call.multi_line) extra_blank = " ";
+
+    CSR_strbuf_addf(
+      &err_str, "%s%s%s (", err_call.chr, extra_blank, err_extra
+    );
     switch(eval_res_c) {
       case -6: {
           R_xlen_t eval_res_len = xlength(eval_tmp);
-          // This could be slow, ideally we would avoid running CSR_smprintf
-          err_tok = CSR_smprintf4(
-            set.nchar_max,
-            "is chr%s: \"%s\"%s%s",
-            eval_res_len > 1 ?
-              CSR_smprintf2(
-                set.nchar_max, " [1:%s]%s", CSR_len_as_chr(eval_res_len),
-                ""
-              ) : "",
-            CHAR(STRING_ELT(eval_tmp, 0)),
-            eval_res_len > 1 ? " ..." : "",
-            ""
+          CSR_strbuf_add(&err_str, "is chr");
+          if(eval_res_len > 1)
+            CSR_strbuf_addf(
+              &err_str, " [1:%s]", CSR_len_as_chr(eval_res_len)
+            );
+          CSR_strbuf_addf(
+            &err_str, ": \"%s\"%s", CHAR(STRING_ELT(eval_tmp, 0)),
+            eval_res_len > 1 ? " ..." : ""
           );
         }
         break;
-      case -2: {
-        const char * err_tok_tmp = type2char(TYPEOF(eval_tmp));
-        const char * err_tok_base = "is \"%s\" instead of a \"logical\"";
-        err_tok = R_alloc(
-          strlen(err_tok_tmp) + strlen(err_tok_base), sizeof(char)
+      case -2:
+        CSR_strbuf_addf(
+          &err_str, "is \"%s\" instead of a \"logical\"",
+          type2char(TYPEOF(eval_tmp))
         );
-        if(sprintf(err_tok, err_tok_base, err_tok_tmp) < 0)
-          // nocov start
-          error(
-            "Internal error: build token error failure; contact maintainer"
-          );
-          // nocov end
-        }
         break;
-      case -1: err_tok = "FALSE"; break;
-      case -3: err_tok = "NA"; break;
-      case -4: err_tok = "contains NAs"; break;
-      // case -5: err_tok = "zero length"; break;
-      case 0: err_tok = "contains non-TRUE values"; break;
+      case -1: CSR_strbuf_add(&err_str, "FALSE"); break;
+      case -3: CSR_strbuf_add(&err_str, "NA"); break;
+      case -4: CSR_strbuf_add(&err_str, "contains NAs"); break;
+      // case -5: CSR_strbuf_add(&err_str, "zero length"); break;
+      case 0: CSR_strbuf_add(&err_str, "contains non-TRUE values"); break;
       default: {
         // nocov start
         error(
@@ -289,57 +638,10 @@ static SEXP VALC_error_standard(
         // nocov end
       }
     }
-    const char * err_extra_a = "is not all TRUE";
-    const char * err_extra_b = "is not TRUE"; // must be shorter than _a
-    const char * err_extra;
-    if(eval_res_c == 0) {
-      err_extra = err_extra_a;
-    } else {
-      err_extra = err_extra_b;
-    }
-    const char * err_base = "%s%s%s (%s)";
-
-    int alloc_size = 0;
-    int str_sizes[4] = {0, 0, 0, 0};
-
-    str_sizes[0] = strlen(err_call.chr);
-    str_sizes[1] = strlen(err_base);
-    str_sizes[2] = strlen(err_extra);
-    str_sizes[3] = strlen(err_tok);
-
-    const char * extra_blank = "";
-    if(!err_call.multi_line) extra_blank = " ";
-
-    for(int i = 0; i < 4; ++i) {
-      if(INT_MAX - str_sizes[i] < alloc_size)
-        // nocov start
-        error(
-          "%s%s (%d)",
-          "Internal Error: error string longer than INT_MAX; ",
-          "contact maintainer.", i
-        );
-        // nocov end
-
-      alloc_size += str_sizes[i];
-    }
-    err_str = R_alloc(alloc_size, sizeof(char));
-
-    // not sure why we're not using cstringr here
-    if(
-      sprintf(
-        err_str, err_base, err_call.chr, extra_blank, err_extra, err_tok
-      ) < 0
-    ) {
-      // nocov start
-      error(
-        "%s%s", "Internal Error: could not construct error message; ",
-        "contact maintainer."
-      );
-      // nocov end
-    }
+    CSR_strbuf_add(&err_str, ")");
   }
   UNPROTECT(1);
-  return mkString(err_str);
+  return mkString(err_str.str);
 }
 static SEXP VALC_error_template(
   struct ALIKEC_res_dat res, SEXP sxp_dat, SEXP arg_lang,
@@ -362,15 +664,133 @@ static SEXP VALC_error_template(
   UNPROTECT(1);
   return res_sxp;
 }
-static SEXP VALC_error_extract(
-  struct VALC_res_node res, SEXP sxp_dat, SEXP arg_tag, SEXP arg_lang,
-  SEXP sys_call, struct VALC_settings set
+/*
+ * Compact unrendered form of a failed token, so that the message need only be
+ * built if it is actually used (see `VALC_evaluate`).
+ *
+ * Standard tokens just keep their `sxp_dat`, although we check the "err.msg"
+ * attribute now so that rendering the message can't fail later.  Template
+ * results live in the arena, so we copy out the strings and recursion indices
+ * which along with the wrap are all that `ALIKEC_res_as_strsxp` uses.
+ *
+ * @return list(sxp_dat, strings, indices), where the last two are NULL for
+ *   standard tokens.
+ */
+#define VALC_FAIL_STRINGS 12
+
+static SEXP VALC_fail_pack(
+  struct VALC_res_node res, SEXP sxp_dat, SEXP arg_tag, SEXP sys_call
 ) {
-  if(res.tpl) {
-    return VALC_error_template(res.tpl_dat, sxp_dat, arg_lang, set);
+  SEXP packed = PROTECT(allocVector(VECSXP, 3));
+  SET_VECTOR_ELT(packed, 0, sxp_dat);
+
+  if(!res.tpl) {
+    VALC_error_attrib(VECTOR_ELT(sxp_dat, 0), arg_tag, sys_call);
   } else {
-    return VALC_error_standard(sxp_dat, arg_tag, arg_lang, sys_call, set);
-  }
+    struct ALIKEC_res_strings strings = res.tpl_dat.strings;
+    SEXP str_sxp = allocVector(STRSXP, VALC_FAIL_STRINGS);
+    SET_VECTOR_ELT(packed, 1, str_sxp);
+    for(int i = 0; i < 5; ++i) {
+      SET_STRING_ELT(str_sxp, i, mkChar(strings.target[i]));
+      SET_STRING_ELT(str_sxp, i + 5, mkChar(strings.current[i]));
+    }
+    SET_STRING_ELT(str_sxp, 10, mkChar(strings.tar_pre));
+    SET_STRING_ELT(str_sxp, 11, mkChar(strings.cur_pre));
+
+    struct ALIKEC_rec_track rec = res.tpl_dat.rec;
+    SEXP ind_sxp = allocVector(VECSXP, (R_xlen_t) rec.lvl_max);
+    SET_VECTOR_ELT(packed, 2, ind_sxp);
+    for(size_t i = 0; i < rec.lvl_max; ++i) {
+      SET_VECTOR_ELT(
+        ind_sxp, (R_xlen_t) i,
+        rec.indices[i].type ?
+          mkString(rec.indices[i].ind.chr) :
+          ScalarReal((double) rec.indices[i].ind.num)
+      );
+  } }
+  UNPROTECT(1);
+  return packed;
+}
+/*
+ * Rebuild the template result from `VALC_fail_pack`; the strings point into
+ * `packed`, which must remain protected while the result is in use.
+ */
+static struct ALIKEC_res_dat VALC_fail_unpack(
+  SEXP packed, struct VALC_arena * arena
+) {
+  SEXP str_sxp = VECTOR_ELT(packed, 1);
+  SEXP ind_sxp = VECTOR_ELT(packed, 2);
+  if(
+    TYPEOF(str_sxp) != STRSXP || XLENGTH(str_sxp) != VALC_FAIL_STRINGS ||
+    TYPEOF(ind_sxp) != VECSXP
+  )
+    // nocov start
+    error("Internal Error: malformed failure data; contact maintainer.");
+    // nocov end
+
+  struct ALIKEC_res_dat res = {.df = 0, .lvl = 0};
+  const char ** chrs = (const char **)
+    VALC_arena_alloc(arena, VALC_FAIL_STRINGS, sizeof(const char *));
+  for(int i = 0; i < VALC_FAIL_STRINGS; ++i)
+    chrs[i] = CHAR(STRING_ELT(str_sxp, i));
+  res.strings = (struct ALIKEC_res_strings) {
+    .target = chrs, .current = chrs + 5, .tar_pre = chrs[10],
+    .cur_pre = chrs[11]
+  };
+  size_t lvl_max = (size_t) XLENGTH(ind_sxp);
+  res.rec = (struct ALIKEC_rec_track) {
+    .envs = NULL, .indices = NULL, .lvl = lvl_max, .lvl_max = lvl_max,
+    .gp = 0
+  };
+  if(lvl_max) {
+    res.rec.indices = (struct ALIKEC_index *)
+      VALC_arena_alloc(arena, lvl_max, sizeof(struct ALIKEC_index));
+    for(size_t i = 0; i < lvl_max; ++i) {
+      SEXP ind = VECTOR_ELT(ind_sxp, (R_xlen_t) i);
+      if(TYPEOF(ind) == STRSXP) {
+        res.rec.indices[i].type = 1;
+        res.rec.indices[i].ind.chr = CHAR(STRING_ELT(ind, 0));
+      } else {
+        res.rec.indices[i].type = 0;
+        res.rec.indices[i].ind.num = (R_xlen_t) asReal(ind);
+  } } }
+  return res;
+}
+/*
+ * Produce the error details from the result of `VALC_evaluate`, in the form
+ * `VALC_process_error` expects, i.e. a list of character vectors.
+ */
+SEXP VALC_fail_render(SEXP fail, struct VALC_settings set) {
+  if(fail == R_NilValue) return allocVector(VECSXP, 0);
+  if(TYPEOF(fail) != VECSXP || XLENGTH(fail) != 4)
+    // nocov start
+    error("Internal Error: malformed failure data; contact maintainer.");
+    // nocov end
+
+  SEXP fails = VECTOR_ELT(fail, 0);
+  SEXP arg_lang = VECTOR_ELT(fail, 1);
+  SEXP arg_tag = VECTOR_ELT(fail, 2);
+  SEXP lang_full = VECTOR_ELT(fail, 3);
+  R_xlen_t fail_n = XLENGTH(fails);
+  SEXP res_as_str = PROTECT(allocVector(VECSXP, fail_n));
+
+  for(R_xlen_t i = 0; i < fail_n; ++i) {
+    SEXP packed = VECTOR_ELT(fails, i);
+    SEXP sxp_dat = VECTOR_ELT(packed, 0);
+    if(VECTOR_ELT(packed, 1) == R_NilValue) {
+      SET_VECTOR_ELT(
+        res_as_str, i,
+        VALC_error_standard(sxp_dat, arg_tag, arg_lang, lang_full, set)
+      );
+    } else {
+      SET_VECTOR_ELT(
+        res_as_str, i,
+        VALC_error_template(
+          VALC_fail_unpack(packed, set.arena), sxp_dat, arg_lang, set
+      ) );
+  } }
+  UNPROTECT(1);
+  return res_as_str;
 }
 /* -------------------------------------------------------------------------- *\
 \* -------------------------------------------------------------------------- */
@@ -385,6 +805,10 @@ static SEXP VALC_error_extract(
   TRUE for `vet`/`tev`, but FALSE for `vetr` as for the latter we have to
   evaluate the version of the vetting token inside the function `vetr` is called
   in
+@return R_NilValue on success, and otherwise the failures in compact form,
+  `list(failures, arg_lang, arg_tag, lang_full)`, which can be turned into the
+  error details with `VALC_fail_render`.  Since failures are often caught and
+  discarded we avoid building messages until they are needed.
 */
 SEXP VALC_evaluate(
   SEXP lang, SEXP arg_lang, SEXP arg_tag, SEXP arg_value, SEXP lang_full,
@@ -406,7 +830,7 @@ SEXP VALC_evaluate(
 
   res_list = VALC_evaluate_recurse(
     lang_eval, VECTOR_ELT(lang_parsed, 1), lang_msg,
-    arg_value, arg_lang, arg_tag, lang_full, set, res_init
+    arg_value, arg_lang, arg_tag, lang_full, set, res_init, 0
   );
   if(res_list.idx == INT_MAX)
     // nocov start
@@ -419,17 +843,22 @@ SEXP VALC_evaluate(
   // all cases if the last recorded item is a success or there are no recorded
   // items, then we pass.
 
-  SEXP res_as_str;
+  SEXP fail;
 
   if(!res_list.idx || res_list.list_tpl[res_list.idx - 1].success) {
-    res_as_str = PROTECT(allocVector(VECSXP, 0));
+    fail = PROTECT(R_NilValue);
   } else {
     // compute how many failures
 
     int fails = 0, j = 0;
     for(int i = 0; i < res_list.idx; ++i)
       fails += !res_list.list_tpl[i].success;
-    res_as_str = PROTECT(allocVector(VECSXP, fails));
+    fail = PROTECT(allocVector(VECSXP, 4));
+    SEXP fail_dat = allocVector(VECSXP, fails);
+    SET_VECTOR_ELT(fail, 0, fail_dat);
+    SET_VECTOR_ELT(fail, 1, arg_lang);
+    SET_VECTOR_ELT(fail, 2, arg_tag);
+    SET_VECTOR_ELT(fail, 3, lang_full);
     SEXP sxp_dat = res_list.list_sxp;
 
     for(int i = 0; i < res_list.idx; ++i) {
@@ -443,10 +872,8 @@ SEXP VALC_evaluate(
         // nocov end
       if(!res.success) {
         SET_VECTOR_ELT(
-          res_as_str, j++,
-          VALC_error_extract(
-            res, CAR(sxp_dat), arg_tag, arg_lang, lang_full, set
-          )
+          fail_dat, j++,
+          VALC_fail_pack(res, CAR(sxp_dat), arg_tag, lang_full)
         );
       }
       sxp_dat = CDR(sxp_dat);
@@ -456,12 +883,17 @@ SEXP VALC_evaluate(
   // check for repeated values.
 
   UNPROTECT(3);
-  return(res_as_str);
+  return(fail);
 }
 SEXP VALC_evaluate_ext(
   SEXP lang, SEXP arg_lang, SEXP arg_tag, SEXP arg_value, SEXP lang_full,
   SEXP rho
 ) {
   struct VALC_settings set = VALC_settings_vet(R_NilValue, rho);
-  return VALC_evaluate(lang, arg_lang, arg_tag, arg_value, lang_full, set, 0);
+  SEXP fail = PROTECT(
+    VALC_evaluate(lang, arg_lang, arg_tag, arg_value, lang_full, set, 0)
+  );
+  SEXP res = VALC_fail_render(fail, set);
+  UNPROTECT(1);
+  return res;
 }
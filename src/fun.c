@@ -39,6 +39,54 @@ fun(a, b, ..., c, d)
 fun(a, b, e, f, ..., g, c, e)
 
 */
+/*
+Formals for specials and builtins.
+
+These are retrieved by evaluating `args(fun)`, which is slow relative to the
+rest of the comparison, so we cache the result by primitive offset for the life
+of the process.  Primitives are never redefined, so there is no need to
+invalidate.  Slots not yet computed hold R_UnboundValue since `args` may
+legitimately return NULL.
+*/
+static SEXP ALIKEC_prim_formals_cache = NULL;
+
+static SEXP ALIKEC_prim_formals(SEXP fun) {
+  int offset = PRIMOFFSET(fun);
+  if(offset < 0)
+    error("Internal Error: negative primitive offset; contact maintainer."); // nocov
+
+  R_xlen_t cache_len = ALIKEC_prim_formals_cache ?
+    XLENGTH(ALIKEC_prim_formals_cache) : 0;
+
+  if(offset >= cache_len) {
+    // Grow (or create) the cache, copying over what we already have
+
+    R_xlen_t new_len = cache_len ? cache_len : 512;
+    while(new_len <= offset) new_len *= 2;
+
+    SEXP cache_new = PROTECT(allocVector(VECSXP, new_len));
+    for(R_xlen_t i = 0; i < new_len; ++i)
+      SET_VECTOR_ELT(
+        cache_new, i,
+        i < cache_len ?
+          VECTOR_ELT(ALIKEC_prim_formals_cache, i) : R_UnboundValue
+      );
+    R_PreserveObject(cache_new);
+    if(ALIKEC_prim_formals_cache)
+      R_ReleaseObject(ALIKEC_prim_formals_cache);
+    ALIKEC_prim_formals_cache = cache_new;
+    UNPROTECT(1);
+  }
+  SEXP formals = VECTOR_ELT(ALIKEC_prim_formals_cache, offset);
+  if(formals == R_UnboundValue) {
+    SEXP args = PROTECT(lang2(ALIKEC_SYM_args, fun));
+    SEXP fun_args = PROTECT(eval(args, R_BaseEnv));
+    formals = TYPEOF(fun_args) == CLOSXP ? FORMALS(fun_args) : R_NilValue;
+    SET_VECTOR_ELT(ALIKEC_prim_formals_cache, offset, formals);
+    UNPROTECT(2);
+  }
+  return formals;
+}
 
 struct ALIKEC_res ALIKEC_fun_alike_internal(
   SEXP target, SEXP current, struct VALC_settings set
@@ -46,28 +94,24 @@ struct ALIKEC_res ALIKEC_fun_alike_internal(
   if(!isFunction(target) || !isFunction(current))
     error("Arguments must be functions.");
 
-  SEXP tar_form, cur_form, args;
+  SEXP tar_form, cur_form, tar_form_all, cur_form_all;
   SEXPTYPE tar_type = TYPEOF(target), cur_type = TYPEOF(current);
-  struct ALIKEC_res res = ALIKEC_res_init();
+  struct ALIKEC_res res = ALIKEC_res_init(set.arena);
 
-  // Translate specials and builtins to formals, if possible
+  // Translate specials and builtins to formals, if possible.  The cached
+  // formals are preserved so need no protection.
 
-  args = PROTECT(list2(ALIKEC_SYM_args, R_NilValue));
-  if(
-    tar_type == SPECIALSXP || tar_type == BUILTINSXP ||
-    cur_type == SPECIALSXP || cur_type == BUILTINSXP
-  ) {
-    SET_TYPEOF(args, LANGSXP);
-  }
   if(tar_type == SPECIALSXP || tar_type == BUILTINSXP) {
-    SETCADR(args, target);
-    target = PROTECT(eval(args, R_BaseEnv));
-  } else PROTECT(R_NilValue);
+    tar_form_all = ALIKEC_prim_formals(target);
+  } else tar_form_all = FORMALS(target);
 
   if(cur_type == SPECIALSXP || cur_type == BUILTINSXP) {
-    SETCADR(args, current);
-    current = PROTECT(eval(args, R_BaseEnv));
-  } else PROTECT(R_NilValue);
+    cur_form_all = ALIKEC_prim_formals(current);
+  } else cur_form_all = FORMALS(current);
+
+  // Same formals (e.g. same primitive) are trivially alike
+
+  if(tar_form_all == cur_form_all) return res;
 
   // Cycle through all formals
 
@@ -76,7 +120,7 @@ struct ALIKEC_res ALIKEC_fun_alike_internal(
   SEXP last_match = R_NilValue, tar_tag, cur_tag;
 
   for(
-    tar_form = FORMALS(target), cur_form = FORMALS(current);
+    tar_form = tar_form_all, cur_form = cur_form_all;
     tar_form != R_NilValue && cur_form != R_NilValue;
     tar_form = CDR(tar_form), cur_form = CDR(cur_form), tar_args++
   ) {
@@ -156,7 +200,6 @@ struct ALIKEC_res ALIKEC_fun_alike_internal(
       res.dat.strings.target[2] = arg_type;
     }
   }
-  UNPROTECT(3);
   if(!res.success) res.wrap = allocVector(VECSXP, 2);
   return res;
 }
@@ -23,7 +23,7 @@ Go to <https://www.r-project.org/Licenses/GPL-2> for a copy of the license.
 static const
 R_CallMethodDef callMethods[] = {
   {"validate", (DL_FUNC) &VALC_validate, 8},
-  {"validate_args", (DL_FUNC) &VALC_validate_args, 5},
+  {"validate_args", (DL_FUNC) &VALC_validate_args, 3},
   {"name_sub", (DL_FUNC) &VALC_name_sub_ext, 2},
   {"symb_sub", (DL_FUNC) &VALC_sub_symbol_ext, 2},
   {"parse", (DL_FUNC) &VALC_parse_ext, 3},
@@ -32,8 +32,14 @@ R_CallMethodDef callMethods[] = {
   {"all", (DL_FUNC) &VALC_all_ext, 1},
   {"track_hash", (DL_FUNC) &VALC_track_hash_test, 2},
   {"default_hash_fun", (DL_FUNC) &VALC_default_hash_fun, 1},
-  {"all_bw", (DL_FUNC) &VALC_all_bw, 5},
+  {"all_bw", (DL_FUNC) &VALC_all_bw, 7},
   {"check_assumptions", (DL_FUNC) &VALC_check_assumptions, 0},
+  {"arena_stats", (DL_FUNC) &VALC_arena_stats, 1},
+  {"bench_time", (DL_FUNC) &VALC_bench_time, 4},
+  {"profile", (DL_FUNC) &VALC_profile, 1},
+  {"stats", (DL_FUNC) &VALC_stats, 1},
+  {"audit", (DL_FUNC) &VALC_audit, 1},
+  {"cond_message", (DL_FUNC) &VALC_cond_message, 1},
 
 /*
   {"test1", (DL_FUNC) &VALC_test1, 1},
@@ -41,6 +47,8 @@ R_CallMethodDef callMethods[] = {
   {"test3", (DL_FUNC) &VALC_test3, 3},
 */
   {"alike_ext", (DL_FUNC) &ALIKEC_alike_ext, 5},
+  {"alike_fast", (DL_FUNC) &ALIKEC_alike_fast_ext, 2},
+  {"memo_hits", (DL_FUNC) &ALIKEC_memo_hits_ext, 1},
   {"typeof", (DL_FUNC) &ALIKEC_typeof, 1},
   {"mode", (DL_FUNC) &ALIKEC_mode, 1},
   {"type_alike", (DL_FUNC) &ALIKEC_type_alike, 4},
@@ -58,10 +66,12 @@ R_CallMethodDef callMethods[] = {
   {"fun_alike", (DL_FUNC) &ALIKEC_fun_alike_ext, 2},
   {"deparse", (DL_FUNC) &ALIKEC_deparse_ext, 2},
   {"deparse_oneline", (DL_FUNC) &ALIKEC_deparse_oneline_ext, 3},
+  {"deparse_chr", (DL_FUNC) &ALIKEC_deparse_chr_ext, 2},
   {"pad", (DL_FUNC) &ALIKEC_pad_ext, 3},
   {"pad_or_quote", (DL_FUNC) &ALIKEC_pad_or_quote_ext, 3},
   {"match_call", (DL_FUNC) &ALIKEC_match_call, 3},
   {"abstract_ts", (DL_FUNC) &ALIKEC_abstract_ts, 2},
+  {"abstract", (DL_FUNC) &ALIKEC_abstract, 3},
   {"env_track", (DL_FUNC) &ALIKEC_env_track_test, 3},
   {"msg_sort", (DL_FUNC) &ALIKEC_sort_msg_ext, 1},
   {"msg_merge", (DL_FUNC) &ALIKEC_merge_msg_ext, 1},
@@ -78,9 +88,12 @@ R_CallMethodDef callMethods[] = {
   {"strmcpy_ext", (DL_FUNC) &CSR_strmcpy_ext, 2},
   {"collapse_ext", (DL_FUNC) &CSR_collapse_ext, 3},
   {"bullet_ext", (DL_FUNC) &CSR_bullet_ext, 4},
+  {"strbuf_ext", (DL_FUNC) &CSR_strbuf_ext, 6},
   {"strsub", (DL_FUNC) &CSR_strsub, 3},
   {"nchar_u", (DL_FUNC) &CSR_nchar_u, 1},
   {"char_offsets", (DL_FUNC) &CSR_char_offsets, 1},
+  {"utf8_locale", (DL_FUNC) &CSR_utf8_locale_ext, 1},
+  {"display_width", (DL_FUNC) &CSR_display_width_ext, 1},
   {"smprintf2_ext", (DL_FUNC) &CSR_smprintf2_ext, 4},
   {"smprintf6_ext", (DL_FUNC) &CSR_smprintf6_ext, 8},
   {"ucfirst_ext", (DL_FUNC) &CSR_ucfirst_ext, 2},
@@ -155,4 +168,7 @@ void R_init_vetr(DllInfo *info)
   ALIKEC_SYM_length = install("length");
   ALIKEC_SYM_syntacticnames = install("syntacticnames");
 }
+void R_unload_vetr(DllInfo *info) {
+  ALIKEC_memo_unload();
+}
 
@@ -143,7 +143,7 @@ struct ALIKEC_res ALIKEC_lang_obj_compare(
   struct VALC_settings set, struct ALIKEC_rec_track rec
 ) {
   SEXP current = CAR(cur_par);
-  struct ALIKEC_res res = ALIKEC_res_init();
+  struct ALIKEC_res res = ALIKEC_res_init(set.arena);
   res.dat.rec = rec;
 
   // Skip parens and increment recursion; not we don't track recursion level
@@ -280,7 +280,7 @@ struct ALIKEC_res ALIKEC_lang_alike_rec(
 
   // If not language object, run comparison
 
-  struct ALIKEC_res res = ALIKEC_res_init();
+  struct ALIKEC_res res = ALIKEC_res_init(set.arena);
   res.dat.rec = rec;
 
   if(TYPEOF(target) != LANGSXP || TYPEOF(current) != LANGSXP) {
@@ -473,9 +473,9 @@ SEXP ALIKEC_lang_alike_core(
   through the language objects
   */
 
-  pfHashTable * tar_hash = pfHashCreate(NULL);
-  pfHashTable * cur_hash = pfHashCreate(NULL);
-  pfHashTable * rev_hash = pfHashCreate(NULL);
+  pfHashTable * tar_hash = pfHashCreate(NULL, set.arena);
+  pfHashTable * cur_hash = pfHashCreate(NULL, set.arena);
+  pfHashTable * rev_hash = pfHashCreate(NULL, set.arena);
   size_t tartmp = 0, curtmp=0;
   size_t * tar_varnum = &tartmp;
   size_t * cur_varnum = &curtmp;
@@ -563,7 +563,7 @@ struct ALIKEC_res ALIKEC_lang_alike_internal(
 ) {
   SEXP lang_res = PROTECT(ALIKEC_lang_alike_core(target, current, set));
 
-  struct ALIKEC_res res = ALIKEC_res_init();
+  struct ALIKEC_res res = ALIKEC_res_init(set.arena);
   if(asInteger(VECTOR_ELT(lang_res, 0))) {
     PROTECT(res.wrap);  // stack balance
   } else {
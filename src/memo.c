@@ -0,0 +1,193 @@
+/*
+Copyright (C) 2020 Brodie Gaslam
+
+This file is part of "vetr - Trust, but Verify"
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+Go to <https://www.r-project.org/Licenses/GPL-2> for a copy of the license.
+*/
+
+#include "alike.h"
+#include <R_ext/Callbacks.h>
+
+/*
+ * Memo of successful template comparisons, enabled with the `memo` setting.
+ *
+ * Pipelines often vet the same unmodified object against the same template in
+ * several functions.  R must duplicate a `MAYBE_SHARED` object before it is
+ * modified, and since we hold a reference to remembered objects they remain
+ * shared, so the object at a remembered address cannot change and the
+ * comparison would succeed again with an equivalent target and settings.
+ *
+ * R can only weakly reference environments and external pointers, so instead
+ * of weak references we hold the objects in a small table that is emptied at
+ * the end of each top level task.  This way the memo never keeps an object
+ * alive past the top level call it was vetted in, and an address can't be
+ * re-used by another object while it is in the table.  The table is set
+ * associative on the address of `current`.  Targets are matched by address,
+ * or failing that with `identical` as templates are usually re-created each
+ * time the vetting token is evaluated.
+ *
+ * Holding a reference does keep the object shared, so a caller that would
+ * otherwise have modified it in place will copy it instead.  We bound that
+ * cost, and the memory the table keeps alive, by only remembering objects with
+ * at most ALIKEC_MEMO_MAX_BYTES of vector data.  Comparisons of larger objects
+ * are repeated each time.
+ *
+ * Only objects made of atomic vectors, lists, and NULL (including attributes)
+ * are remembered since e.g. environments can change without being duplicated,
+ * and language and S4 comparisons depend on the evaluation environment.
+ */
+
+#define ALIKEC_MEMO_SETS  16
+#define ALIKEC_MEMO_WAYS  4
+#define ALIKEC_MEMO_DEPTH 64    // max nesting of remembered objects
+#define ALIKEC_MEMO_PARAMS 9
+#define ALIKEC_MEMO_MAX_BYTES 65536   // max vector data in remembered objects
+
+static SEXP ALIKEC_memo_tab = NULL;  // list(current, target, params) entries
+static int ALIKEC_memo_next[ALIKEC_MEMO_SETS];  // next way to overwrite
+static int ALIKEC_memo_used = 0;
+static double ALIKEC_memo_hits = 0;    // for testing
+
+static Rboolean ALIKEC_memo_clear(
+  SEXP expr, SEXP value, Rboolean succeeded, Rboolean visible, void * data
+) {
+  if(ALIKEC_memo_used) {
+    for(R_xlen_t i = 0; i < XLENGTH(ALIKEC_memo_tab); ++i)
+      SET_VECTOR_ELT(ALIKEC_memo_tab, i, R_NilValue);
+    ALIKEC_memo_used = 0;
+  }
+  return TRUE;
+}
+static void ALIKEC_memo_init(void) {
+  ALIKEC_memo_tab =
+    allocVector(VECSXP, ALIKEC_MEMO_SETS * ALIKEC_MEMO_WAYS);
+  R_PreserveObject(ALIKEC_memo_tab);
+  Rf_addTaskCallback(ALIKEC_memo_clear, NULL, NULL, "vetr_memo", NULL);
+}
+/*
+ * Called when the DLL is unloaded, as otherwise R would call the task callback
+ * after its code is gone.
+ */
+void ALIKEC_memo_unload(void) {
+  if(!ALIKEC_memo_tab) return;
+  Rf_removeTaskCallbackByName("vetr_memo");
+  R_ReleaseObject(ALIKEC_memo_tab);
+  ALIKEC_memo_tab = NULL;
+  ALIKEC_memo_used = 0;
+}
+/*
+ * Whether an object can only change by being duplicated, and is small enough
+ * to remember; `bytes` accumulates the size of the vector data seen so far.
+ */
+static int ALIKEC_memo_plain(SEXP x, int depth, size_t * bytes) {
+  if(depth > ALIKEC_MEMO_DEPTH || IS_S4_OBJECT(x)) return 0;
+  size_t elt_size;
+  switch(TYPEOF(x)) {
+    case NILSXP: return 1;
+    case LGLSXP: elt_size = sizeof(int); break;
+    case INTSXP: elt_size = sizeof(int); break;
+    case REALSXP: elt_size = sizeof(double); break;
+    case CPLXSXP: elt_size = sizeof(Rcomplex); break;
+    case STRSXP: elt_size = sizeof(SEXP); break;
+    case RAWSXP: elt_size = sizeof(Rbyte); break;
+    case VECSXP: elt_size = sizeof(SEXP); break;
+    default:
+      return 0;
+  }
+  if((size_t) XLENGTH(x) > (ALIKEC_MEMO_MAX_BYTES - *bytes) / elt_size)
+    return 0;
+  *bytes += (size_t) XLENGTH(x) * elt_size;
+
+  if(TYPEOF(x) == VECSXP)
+    for(R_xlen_t i = 0; i < XLENGTH(x); ++i)
+      if(!ALIKEC_memo_plain(VECTOR_ELT(x, i), depth + 1, bytes)) return 0;
+  for(SEXP attr = ATTRIB(x); attr != R_NilValue; attr = CDR(attr))
+    if(!ALIKEC_memo_plain(CAR(attr), depth + 1, bytes)) return 0;
+  return 1;
+}
+/*
+ * Settings that may affect whether a comparison of plain objects succeeds
+ */
+static void ALIKEC_memo_params(int * params, struct VALC_settings set) {
+  params[0] = set.type_mode;
+  params[1] = set.attr_mode;
+  params[2] = set.lang_mode;
+  params[3] = set.fun_mode;
+  params[4] = set.rec_mode;
+  params[5] = set.fuzzy_int_max_len;
+  params[6] = set.elt_sample;
+  params[7] = set.elt_seed;
+  params[8] = set.df_mode;
+}
+static R_xlen_t ALIKEC_memo_set_of(SEXP current) {
+  return (R_xlen_t) ((((uintptr_t) current) >> 4) % ALIKEC_MEMO_SETS);
+}
+/*
+ * @return 1 if `target` was already found to be alike `current`
+ */
+int ALIKEC_memo_get(SEXP target, SEXP current, struct VALC_settings set) {
+  if(!ALIKEC_memo_used || !MAYBE_SHARED(current)) return 0;
+
+  int params[ALIKEC_MEMO_PARAMS];
+  ALIKEC_memo_params(params, set);
+  R_xlen_t first = ALIKEC_memo_set_of(current) * ALIKEC_MEMO_WAYS;
+
+  for(R_xlen_t i = first; i < first + ALIKEC_MEMO_WAYS; ++i) {
+    SEXP entry = VECTOR_ELT(ALIKEC_memo_tab, i);
+    if(entry == R_NilValue || VECTOR_ELT(entry, 0) != current) continue;
+    if(memcmp(INTEGER(VECTOR_ELT(entry, 2)), params, sizeof(params)))
+      continue;
+
+    SEXP entry_tar = VECTOR_ELT(entry, 1);
+    if(entry_tar == target || R_compute_identical(entry_tar, target, 16)) {
+      ++ALIKEC_memo_hits;
+      return 1;
+    }
+  }
+  return 0;
+}
+/*
+ * Remember that `target` is alike `current`, if both objects qualify
+ */
+void ALIKEC_memo_add(SEXP target, SEXP current, struct VALC_settings set) {
+  size_t bytes_cur = 0, bytes_tar = 0;
+  if(
+    !MAYBE_SHARED(current) || !ALIKEC_memo_plain(current, 0, &bytes_cur) ||
+    !ALIKEC_memo_plain(target, 0, &bytes_tar)
+  )
+    return;
+  if(!ALIKEC_memo_tab) ALIKEC_memo_init();
+
+  SEXP entry = PROTECT(allocVector(VECSXP, 3));
+  SET_VECTOR_ELT(entry, 0, current);
+  SET_VECTOR_ELT(entry, 1, target);
+  SEXP params = allocVector(INTSXP, ALIKEC_MEMO_PARAMS);
+  SET_VECTOR_ELT(entry, 2, params);
+  ALIKEC_memo_params(INTEGER(params), set);
+
+  R_xlen_t set_i = ALIKEC_memo_set_of(current);
+  R_xlen_t i = set_i * ALIKEC_MEMO_WAYS + ALIKEC_memo_next[set_i];
+  ALIKEC_memo_next[set_i] = (ALIKEC_memo_next[set_i] + 1) % ALIKEC_MEMO_WAYS;
+  SET_VECTOR_ELT(ALIKEC_memo_tab, i, entry);
+  ALIKEC_memo_used = 1;
+  UNPROTECT(1);
+}
+/*
+ * For testing; number of memo hits since the last reset
+ */
+SEXP ALIKEC_memo_hits_ext(SEXP reset) {
+  SEXP res = ScalarReal(ALIKEC_memo_hits);
+  if(asLogical(reset) == 1) ALIKEC_memo_hits = 0;
+  return res;
+}
@@ -108,39 +108,57 @@ SEXP ALIKEC_sort_msg_ext(SEXP msgs) {
   return ALIKEC_sort_msg(msgs, set);
 }
 /*
- * Dedup messages, however, note that you are expected to sort the input first
- * as this only dedups adjacent values.
+ * Message grouping
  *
- * Note this only creates a new vector if there are duplicates within.
+ * Messages are grouped by the first, second, fourth, and fifth elements via a
+ * hash table so that we don't need to sort the full list of (possibly long)
+ * messages to find the groups.  One length messages form a group of their own.
+ *
+ * To keep the output identical to what it was when we sorted the whole list
+ * the groups are then ordered by the same key we used to sort by, including
+ * the smallest third element in the group, and the third elements within each
+ * group are sorted before they are merged.  In the
+ * typical case there are few groups so there is little to sort.
  */
-static SEXP ALIKEC_unique_msg(SEXP msgs) {
-  R_xlen_t len = xlength(msgs);
-  if(len < 2) return(msgs);
-
-  // Loop once to check for dupes
+struct ALIKEC_msg_group {
+  R_xlen_t first;      // index of first message in group
+  R_xlen_t last;       // index of last message, members chained by `next`
+  R_xlen_t count;
+  size_t hash;
+};
+static size_t ALIKEC_msg_hash_chr(size_t hash, const char * chr) {
+  // FNV-1a, with a separator so component boundaries matter
 
-  int some_dup = 0;
-  for(R_xlen_t i = 1; i < len; ++i) {
-    if(R_compute_identical(VECTOR_ELT(msgs, i - 1), VECTOR_ELT(msgs, i), 16)) {
-      some_dup = 1;
-      break;
-    }
-  }
-  SEXP res;
-  if(some_dup) {
-    res = PROTECT(allocVector(VECSXP, len));
-    SET_VECTOR_ELT(res, 0, VECTOR_ELT(msgs, 0));
-    R_xlen_t j = 1;
-    for(R_xlen_t i = 1; i < len; ++i) {
-      if(
-        !R_compute_identical(VECTOR_ELT(msgs, i - 1), VECTOR_ELT(msgs, i), 16)
-      ) {
-        SET_VECTOR_ELT(res, j++, VECTOR_ELT(msgs, i));
-      }
-    }
-    SETLENGTH(res, j);
-    UNPROTECT(1);
-  } else res = msgs;
+  for(; *chr; ++chr) hash = (hash ^ (unsigned char) *chr) * 16777619U;
+  return (hash ^ 0xFF) * 16777619U;
+}
+static size_t ALIKEC_msg_hash(SEXP msg) {
+  size_t hash = 2166136261U;
+  if(XLENGTH(msg) == 1) return ALIKEC_msg_hash_chr(hash, CHAR(asChar(msg)));
+
+  const int elts[4] = {0, 1, 3, 4};
+  for(int i = 0; i < 4; ++i)
+    hash = ALIKEC_msg_hash_chr(hash, CHAR(STRING_ELT(msg, elts[i])));
+  return hash;
+}
+static int ALIKEC_msg_same_group(SEXP a, SEXP b) {
+  if(XLENGTH(a) != XLENGTH(b)) return 0;
+  if(XLENGTH(a) == 1) return !strcmp(CHAR(asChar(a)), CHAR(asChar(b)));
+  return
+    !strcmp(CHAR(STRING_ELT(a, 0)), CHAR(STRING_ELT(b, 0))) &&
+    !strcmp(CHAR(STRING_ELT(a, 1)), CHAR(STRING_ELT(b, 1))) &&
+    !strcmp(CHAR(STRING_ELT(a, 3)), CHAR(STRING_ELT(b, 3))) &&
+    !strcmp(CHAR(STRING_ELT(a, 4)), CHAR(STRING_ELT(b, 4)));
+}
+/*
+ * Sort members of a group by their third element, using the index as a tie
+ * breaker so the sort is stable.
+ */
+static int ALIKEC_msg_member_comp(const void *p, const void *q) {
+  struct ALIKEC_sort_dat a = *(struct ALIKEC_sort_dat *) p;
+  struct ALIKEC_sort_dat b = *(struct ALIKEC_sort_dat *) q;
+  int res = strcmp(a.string, b.string);
+  if(!res) res = (a.index > b.index) - (a.index < b.index);
   return res;
 }
 /*
@@ -155,93 +173,153 @@ static SEXP ALIKEC_unique_msg(SEXP msgs) {
  */
 
 SEXP ALIKEC_merge_msg(SEXP msgs, struct VALC_settings set) {
-  SEXP res;
-
-  if(XLENGTH(msgs) > 1) {
-    // 1. Sort the strings (really only need to do this if longer than 3, but oh
-    // well
-    SEXP msg_sort = PROTECT(ALIKEC_sort_msg(msgs, set));
-    SEXP msg_sort_c = PROTECT(ALIKEC_unique_msg(msg_sort));
-
-    R_xlen_t len = XLENGTH(msg_sort_c), groups = 1;
-
-    // Determine how many groups of similar things there are in our list
+  if(TYPEOF(msgs) != VECSXP) {
+    error("Expected list argument, got %s", type2char(TYPEOF(msgs)));
+  }
+  R_xlen_t len = XLENGTH(msgs);
+  if(len < 2) return msgs;
 
-    for(R_xlen_t i=1; i < len; i++) {
-      SEXP v_elt = VECTOR_ELT(msg_sort_c, i);
-      SEXP v_elt_prv = VECTOR_ELT(msg_sort_c, i - 1);
+  for(R_xlen_t i = 0; i < len; i++) {
+    SEXP str_elt = VECTOR_ELT(msgs, i);
+    if(
+      TYPEOF(str_elt) != STRSXP ||
+      (XLENGTH(str_elt) != 5 && XLENGTH(str_elt) != 1)
+    ) {
+      // nocov start
+      error(
+        "Internal Error: unexpected string format to merge; contact maintainer"
+      );
+      // nocov end
+    }
+  }
+  // Hash table size is a power of two at least twice the number of messages,
+  // open addressing with linear probing; slots contain group index + 1
+
+  size_t tbl_size = 16;
+  while(tbl_size < (size_t) len * 2) tbl_size = CSR_add_szt(tbl_size, tbl_size);
+
+  R_xlen_t * tbl = (R_xlen_t *)
+    VALC_arena_alloc(set.arena, tbl_size, sizeof(R_xlen_t));
+  memset(tbl, 0, tbl_size * sizeof(R_xlen_t));
+  R_xlen_t * next = (R_xlen_t *)
+    VALC_arena_alloc(set.arena, (size_t) len, sizeof(R_xlen_t));
+  struct ALIKEC_msg_group * groups = (struct ALIKEC_msg_group *)
+    VALC_arena_alloc(
+      set.arena, (size_t) len, sizeof(struct ALIKEC_msg_group)
+    );
+  R_xlen_t group_n = 0;
+
+  for(R_xlen_t i = 0; i < len; ++i) {
+    SEXP msg = VECTOR_ELT(msgs, i);
+    size_t hash = ALIKEC_msg_hash(msg);
+    size_t slot = hash & (tbl_size - 1);
+    next[i] = -1;
+
+    while(tbl[slot]) {
+      struct ALIKEC_msg_group * group = groups + tbl[slot] - 1;
       if(
-        XLENGTH(v_elt) == 1 ||
-        strcmp(CHAR(STRING_ELT(v_elt, 0)), CHAR(STRING_ELT(v_elt_prv, 0))) ||
-        strcmp(CHAR(STRING_ELT(v_elt, 1)), CHAR(STRING_ELT(v_elt_prv, 1))) ||
-        strcmp(CHAR(STRING_ELT(v_elt, 3)), CHAR(STRING_ELT(v_elt_prv, 3))) ||
-        strcmp(CHAR(STRING_ELT(v_elt, 4)), CHAR(STRING_ELT(v_elt_prv, 4)))
-      ) {
-        ++groups;
-      }
+        group->hash == hash &&
+        ALIKEC_msg_same_group(VECTOR_ELT(msgs, group->first), msg)
+      )
+        break;
+      slot = (slot + 1) & (tbl_size - 1);
     }
-    // If we need to condense the list, then allocate it, otherwise just return
-    // the original list
-
-    if(groups < len) {
-      res = PROTECT(allocVector(VECSXP, groups));
-      R_xlen_t k = 0;      // count the index in our result vector
-      R_xlen_t j = 0;      // count how many elements in group
-      // this will be the concatented second value in our vectors
-
-      const char * target = "";
-
-      for(R_xlen_t i=0; i < len; i++) {
-
-        SEXP v_elt_nxt = R_NilValue, v_elt = VECTOR_ELT(msg_sort_c, i);
-
-        if(i < len - 1) {
-          v_elt_nxt = VECTOR_ELT(msg_sort_c, i + 1);
-        }
-        // Note, we'll only ever acces v_elt_nxt if we're not at the last value
-        // in the loop so it is okay for it to be R_NilValue in that iteration
-
-        int next_diff = (i == len - 1) ||
-          XLENGTH(v_elt) == 1 ||
-          strcmp(CHAR(STRING_ELT(v_elt, 0)), CHAR(STRING_ELT(v_elt_nxt, 0))) ||
-          strcmp(CHAR(STRING_ELT(v_elt, 1)), CHAR(STRING_ELT(v_elt_nxt, 1))) ||
-          strcmp(CHAR(STRING_ELT(v_elt, 3)), CHAR(STRING_ELT(v_elt_nxt, 3))) ||
-          strcmp(CHAR(STRING_ELT(v_elt, 4)), CHAR(STRING_ELT(v_elt_nxt, 4)));
-
-        if(next_diff) {
-          SEXP v_elt_d = PROTECT(duplicate(v_elt));
-          SET_VECTOR_ELT(res, k, v_elt_d);
-          UNPROTECT(1);
-
-          // append with, "or" if necessary and write
-
-          if(j) {
-            target = CSR_smprintf4(
-              set.nchar_max, "%s, or %s",
-              target, CHAR(STRING_ELT(v_elt_d, 2)), "", ""
-            );
-            SET_STRING_ELT(v_elt_d, 2, mkChar(target));
-          }
-          j = 0;
-          ++k;
-        } else {
-          // more than one value, but not done yet
-
-          if(j) {
-            target = CSR_smprintf4(
-              set.nchar_max, "%s, %s",
-              target, CHAR(STRING_ELT(v_elt, 2)), "", ""
-            );
-          } else target = CHAR(STRING_ELT(v_elt, 2));
-          ++j;
-        }
-      }
+    if(tbl[slot]) {
+      struct ALIKEC_msg_group * group = groups + tbl[slot] - 1;
+      next[group->last] = i;
+      group->last = i;
+      ++(group->count);
     } else {
-      res = PROTECT(msg_sort_c); // stack balance
+      groups[group_n] = (struct ALIKEC_msg_group) {
+        .first = i, .last = i, .count = 1, .hash = hash
+      };
+      tbl[slot] = ++group_n;
     }
-  } else res = PROTECT(PROTECT(PROTECT(msgs))); // stack balance
-
-  UNPROTECT(3);
+  }
+  // Order groups by the key we used to sort by in the past.  That key ends
+  // with the third element so each group sorted where its member with the
+  // smallest third element did.  This matters when one group's key is a prefix
+  // of another's, or when keys are truncated at `nchar.max`.
+
+  struct ALIKEC_sort_dat * group_ord = (struct ALIKEC_sort_dat *)
+    VALC_arena_alloc(
+      set.arena, (size_t) group_n, sizeof(struct ALIKEC_sort_dat)
+    );
+  for(R_xlen_t g = 0; g < group_n; ++g) {
+    SEXP msg = VECTOR_ELT(msgs, groups[g].first);
+    const char * key;
+    if(XLENGTH(msg) == 1) {
+      key = CHAR(asChar(msg));
+    } else {
+      const char * c2_min = CHAR(STRING_ELT(msg, 2));
+      for(R_xlen_t i = next[groups[g].first]; i >= 0; i = next[i]) {
+        const char * c2 = CHAR(STRING_ELT(VECTOR_ELT(msgs, i), 2));
+        if(strcmp(c2, c2_min) < 0) c2_min = c2;
+      }
+      struct CSR_strbuf key_buf = CSR_strbuf_init(set.nchar_max, set.arena);
+      CSR_strbuf_addf(
+        &key_buf, "%s <:> %s <:> %s <:> %s <:> %s",
+        CHAR(STRING_ELT(msg, 0)), CHAR(STRING_ELT(msg, 1)),
+        CHAR(STRING_ELT(msg, 3)), CHAR(STRING_ELT(msg, 4)), c2_min
+      );
+      key = key_buf.str;
+    }
+    group_ord[g] = (struct ALIKEC_sort_dat) {key, g};
+  }
+  qsort(
+    group_ord, (size_t) group_n, sizeof(struct ALIKEC_sort_dat),
+    ALIKEC_msg_member_comp
+  );
+  // Merge each group; identical messages will be adjacent after sorting the
+  // members by their third element so we skip them
+
+  SEXP res = PROTECT(allocVector(VECSXP, group_n));
+  struct ALIKEC_sort_dat * members = (struct ALIKEC_sort_dat *)
+    VALC_arena_alloc(set.arena, (size_t) len, sizeof(struct ALIKEC_sort_dat));
+
+  for(R_xlen_t g = 0; g < group_n; ++g) {
+    struct ALIKEC_msg_group group = groups[group_ord[g].index];
+    SEXP msg_first = VECTOR_ELT(msgs, group.first);
+
+    if(group.count == 1 || XLENGTH(msg_first) == 1) {
+      SET_VECTOR_ELT(res, g, msg_first);
+      continue;
+    }
+    R_xlen_t m = 0;
+    for(R_xlen_t i = group.first; i >= 0; i = next[i])
+      members[m++] = (struct ALIKEC_sort_dat) {
+        CHAR(STRING_ELT(VECTOR_ELT(msgs, i), 2)), i
+      };
+    qsort(
+      members, (size_t) m, sizeof(struct ALIKEC_sort_dat),
+      ALIKEC_msg_member_comp
+    );
+    R_xlen_t m_u = 0;   // unique members
+    for(R_xlen_t i = 0; i < m; ++i) {
+      if(
+        !i || !R_compute_identical(
+          VECTOR_ELT(msgs, members[m_u - 1].index),
+          VECTOR_ELT(msgs, members[i].index), 16
+        )
+      )
+        members[m_u++] = members[i];
+    }
+    SEXP msg_last = VECTOR_ELT(msgs, members[m_u - 1].index);
+    if(m_u == 1) {
+      SET_VECTOR_ELT(res, g, msg_last);
+      continue;
+    }
+    struct CSR_strbuf target = CSR_strbuf_init(set.nchar_max, set.arena);
+    for(R_xlen_t i = 0; i < m_u; ++i) {
+      if(i) CSR_strbuf_add(&target, i == m_u - 1 ? ", or " : ", ");
+      CSR_strbuf_add(&target, members[i].string);
+    }
+    SEXP msg_new = PROTECT(duplicate(msg_last));
+    SET_STRING_ELT(msg_new, 2, mkChar(target.str));
+    SET_VECTOR_ELT(res, g, msg_new);
+    UNPROTECT(1);
+  }
+  UNPROTECT(1);
   return res;
 }
 SEXP ALIKEC_merge_msg_ext(SEXP msgs) {
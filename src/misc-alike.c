@@ -18,6 +18,7 @@ Go to <https://www.r-project.org/Licenses/GPL-2> for a copy of the license.
 
 #include "alike.h"
 #include "pfhash.h"
+#include <math.h>
 #include <time.h>
 
 // - Helper Functions ----------------------------------------------------------
@@ -97,11 +98,191 @@ SEXP ALIKEC_abstract_ts(SEXP x, SEXP attr) {
   return x_cp;
 }
 /*
+Native deparse for the simple language that makes up the bulk of our error
+messages: syntactic symbols, `[[`, `[`, and `$` index chains such as those
+produced by `ALIKEC_rec_ind_as_lang`, and short calls such as `attr(x, "a")`
+or `names(x)` with atomic scalar arguments.
+
+Output must be identical to what `deparse` would produce, so we are very
+conservative: anything we are not certain about, including anything that would
+be long enough to cause `deparse` to break lines, makes us give up and we fall
+back to `deparse` proper.  Numbers are limited to those that `deparse` always
+shows in fixed notation, and strings to printable ASCII.
+*/
+#define ALIKEC_DEP_BUFF 512
+#define ALIKEC_DEP_DEPTH 32
+
+struct ALIKEC_dep_buff {
+  char buff[ALIKEC_DEP_BUFF];
+  size_t len;
+  size_t max;   // max length, must be less than ALIKEC_DEP_BUFF
+};
+static int ALIKEC_dep_add(struct ALIKEC_dep_buff * b, const char * chr) {
+  size_t len = strlen(chr);
+  if(len > b->max - b->len) return 0;
+  memcpy(b->buff + b->len, chr, len);
+  b->len += len;
+  return 1;
+}
+static int ALIKEC_dep_sym_ok(SEXP sym) {
+  if(sym == R_MissingArg) return 0;
+  const char * chr = CHAR(PRINTNAME(sym));
+  for(const char * p = chr; *p; ++p) if((unsigned char) *p > 127) return 0;
+  return *chr && ALIKEC_is_valid_name(chr);
+}
+static int ALIKEC_dep_scalar(struct ALIKEC_dep_buff * b, SEXP obj) {
+  SEXPTYPE type = TYPEOF(obj);
+  if(
+    (type != LGLSXP && type != INTSXP && type != REALSXP && type != STRSXP) ||
+    XLENGTH(obj) != 1 || ATTRIB(obj) != R_NilValue
+  )
+    return 0;
+
+  char num[32];
+  switch(type) {
+    case LGLSXP: {
+      int val = LOGICAL(obj)[0];
+      return ALIKEC_dep_add(
+        b, val == NA_LOGICAL ? "NA" : (val ? "TRUE" : "FALSE")
+      );
+    }
+    case INTSXP: {
+      int val = INTEGER(obj)[0];
+      if(val == NA_INTEGER) return 0;
+      snprintf(num, sizeof(num), "%dL", val);
+      return ALIKEC_dep_add(b, num);
+    }
+    case REALSXP: {
+      // Only non-negative integer values that deparse in fixed notation
+
+      double val = REAL(obj)[0];
+      if(
+        !R_FINITE(val) || signbit(val) || val >= 1e5 ||
+        val != (double) (int) val
+      )
+        return 0;
+      snprintf(num, sizeof(num), "%d", (int) val);
+      return ALIKEC_dep_add(b, num);
+    }
+    case STRSXP: {
+      SEXP chrsxp = STRING_ELT(obj, 0);
+      if(chrsxp == NA_STRING) return 0;
+      const char * chr = CHAR(chrsxp);
+      if(!ALIKEC_dep_add(b, "\"")) return 0;
+      for(; *chr; ++chr) {
+        if((unsigned char) *chr < 32 || (unsigned char) *chr > 126) return 0;
+        if(
+          ((*chr == '"' || *chr == '\\') && !ALIKEC_dep_add(b, "\\")) ||
+          b->len >= b->max
+        )
+          return 0;
+        b->buff[b->len++] = *chr;
+      }
+      return ALIKEC_dep_add(b, "\"");
+    }
+  }
+  return 0;
+}
+static int ALIKEC_dep_rec(
+  struct ALIKEC_dep_buff * b, SEXP obj, int depth
+) {
+  if(depth > ALIKEC_DEP_DEPTH) return 0;
+
+  switch(TYPEOF(obj)) {
+    case SYMSXP:
+      return ALIKEC_dep_sym_ok(obj) && ALIKEC_dep_add(b, CHAR(PRINTNAME(obj)));
+    case LANGSXP: break;
+    default: return ALIKEC_dep_scalar(b, obj);
+  }
+  SEXP fun = CAR(obj), args = CDR(obj);
+  if(TYPEOF(fun) != SYMSXP || ATTRIB(obj) != R_NilValue) return 0;
+
+  const char * open, * close = "";
+
+  if(fun == R_DollarSymbol) {
+    // Only `x$name`, where `x` is itself a symbol or call we can handle
+
+    if(
+      TYPEOF(args) != LISTSXP || TAG(args) != R_NilValue ||
+      CDR(args) == R_NilValue || CDDR(args) != R_NilValue ||
+      TAG(CDR(args)) != R_NilValue || TYPEOF(CADR(args)) != SYMSXP ||
+      (TYPEOF(CAR(args)) != SYMSXP && TYPEOF(CAR(args)) != LANGSXP)
+    )
+      return 0;
+    return
+      ALIKEC_dep_rec(b, CAR(args), depth + 1) && ALIKEC_dep_add(b, "$") &&
+      ALIKEC_dep_rec(b, CADR(args), depth + 1);
+  } else if (fun == R_Bracket2Symbol || fun == R_BracketSymbol) {
+    if(
+      TYPEOF(args) != LISTSXP || TAG(args) != R_NilValue ||
+      (TYPEOF(CAR(args)) != SYMSXP && TYPEOF(CAR(args)) != LANGSXP)
+    )
+      return 0;
+    if(!ALIKEC_dep_rec(b, CAR(args), depth + 1)) return 0;
+    args = CDR(args);
+    if(fun == R_Bracket2Symbol) {
+      open = "[[";
+      close = "]]";
+    } else {
+      open = "[";
+      close = "]";
+    }
+  } else {
+    if(!ALIKEC_dep_sym_ok(fun) || !ALIKEC_dep_add(b, CHAR(PRINTNAME(fun))))
+      return 0;
+    open = "(";
+    close = ")";
+  }
+  if(!ALIKEC_dep_add(b, open)) return 0;
+
+  for(SEXP arg = args; arg != R_NilValue; arg = CDR(arg)) {
+    if(TYPEOF(arg) != LISTSXP) return 0;
+    if(arg != args && !ALIKEC_dep_add(b, ", ")) return 0;
+    if(TAG(arg) != R_NilValue) {
+      if(
+        !ALIKEC_dep_sym_ok(TAG(arg)) ||
+        !ALIKEC_dep_add(b, CHAR(PRINTNAME(TAG(arg)))) ||
+        !ALIKEC_dep_add(b, " = ")
+      )
+        return 0;
+    }
+    if(!ALIKEC_dep_rec(b, CAR(arg), depth + 1)) return 0;
+  }
+  return ALIKEC_dep_add(b, close);
+}
+/*
+Returns a character(1L) with the deparsed object, or R_NilValue if we could not
+deparse it.  `width_cutoff` has the same meaning as in ALIKEC_deparse_core.
+*/
+SEXP ALIKEC_deparse_fast(SEXP obj, int width_cutoff) {
+  if(width_cutoff < 0) width_cutoff = 60;
+  else if(width_cutoff < 20 || width_cutoff > 500) return R_NilValue;
+
+  // `deparse` only breaks lines once they exceed `width.cutoff` bytes
+
+  struct ALIKEC_dep_buff b = {
+    .len = 0,
+    .max = width_cutoff < ALIKEC_DEP_BUFF ?
+      (size_t) width_cutoff : ALIKEC_DEP_BUFF - 1
+  };
+  if(!ALIKEC_dep_rec(&b, obj, 0)) return R_NilValue;
+
+  b.buff[b.len] = '\0';
+  return mkString(b.buff);
+}
+/*
 Run deparse command and return character vector with results
 
 set width_cutoff to be less than zero to use default
 */
 SEXP ALIKEC_deparse_core(SEXP obj, int width_cutoff) {
+  VALC_PROF_START(prof_start);
+  SEXP res_fast = ALIKEC_deparse_fast(obj, width_cutoff);
+  if(res_fast != R_NilValue) {
+    VALC_PROF_END(VALC_PROF_DEPARSE, prof_start);
+    return res_fast;
+  }
+
   SEXP quot_call = PROTECT(list2(R_QuoteSymbol, obj));
   SEXP dep_call;
 
@@ -118,6 +299,7 @@ SEXP ALIKEC_deparse_core(SEXP obj, int width_cutoff) {
   SET_TYPEOF(dep_call, LANGSXP);
   SEXP res = eval(dep_call, R_BaseEnv);
   UNPROTECT(2);
+  VALC_PROF_END(VALC_PROF_DEPARSE, prof_start);
   return res;
 }
 /*
@@ -136,23 +318,53 @@ const char * ALIKEC_deparse_oneline(
 
   const char * res, * dep_line;
   SEXP dep_line_sexp = PROTECT(ALIKEC_deparse_core(obj, 500));
-  dep_line = CHAR(STRING_ELT(dep_line_sexp, 0));
+  SEXP dep_line_chr = STRING_ELT(dep_line_sexp, 0);
+  dep_line = CHAR(dep_line_chr);
+  int utf8 = CSR_chr_is_utf8(dep_line_chr);
   UNPROTECT(1);
 
   size_t dep_len = CSR_strmlen(dep_line, set.nchar_max);
 
-  if(dep_len > max_chars) {
+  // `max_chars` and `keep_at_end` are in display columns; we only split
+  // between characters
+
+  if(CSR_display_width(dep_line, dep_len, utf8) > max_chars) {
     // truncate string and use '..' at the end
 
-    char * res_tmp = R_alloc(dep_len + 1, sizeof(char));
-    size_t i, j;
-    for(i = 0; i < max_chars - keep_at_end - 2; i++) res_tmp[i] = dep_line[i];
-    res_tmp[i] = res_tmp[i + 1] = '.';
-    i += 2;
-    for(j = dep_len - keep_at_end; j < dep_len && i < dep_len; j++, i++) {
-      res_tmp[i] = dep_line[j];
+    size_t head = CSR_display_fit(
+      dep_line, max_chars - keep_at_end - 2, dep_len, utf8
+    );
+    // Step back a character at a time while the tail fits in `keep_at_end`
+    // columns, then drop any zero width characters left without the character
+    // they combine with.
+
+    size_t tail = dep_len, tail_width = 0;
+    while(tail > head) {
+      size_t prev = tail - 1;
+      while(
+        utf8 && prev > head &&
+        UTF8_IS_CONT((unsigned const char *) dep_line + prev)
+      )
+        prev--;
+      tail_width += CSR_display_width(dep_line + prev, tail - prev, utf8);
+      if(tail_width > keep_at_end) break;
+      tail = prev;
+    }
+    while(tail < dep_len) {
+      size_t next = tail + 1;
+      while(
+        utf8 && next < dep_len &&
+        UTF8_IS_CONT((unsigned const char *) dep_line + next)
+      )
+        next++;
+      if(CSR_display_width(dep_line + tail, next - tail, utf8)) break;
+      tail = next;
     }
-    res_tmp[i] = '\0';
+    char * res_tmp = R_alloc(head + 2 + dep_len - tail + 1, sizeof(char));
+    memcpy(res_tmp, dep_line, head);
+    res_tmp[head] = res_tmp[head + 1] = '.';
+    memcpy(res_tmp + head + 2, dep_line + tail, dep_len - tail);
+    res_tmp[head + 2 + dep_len - tail] = '\0';
     res = (const char *) res_tmp;
   } else res = dep_line;
 
@@ -213,7 +425,7 @@ const char * ALIKEC_pad(
 
   if(lines < 0) lines = line_max;
 
-  char * res = "";
+  struct CSR_strbuf res = CSR_strbuf_init(set.nchar_max, set.arena);
   const char * dep_prompt = "", * dep_continue = "";
 
   // Figure out what to use as prompt and continue
@@ -248,12 +460,12 @@ const char * ALIKEC_pad(
     const char * dep_pad = "";
     const char * dep_err = CHAR(STRING_ELT(obj, i));
     if(!i) dep_pad = dep_prompt; else dep_pad = dep_continue;
-    res = CSR_smprintf6(
-      set.nchar_max, "%s%s%s%s%s%s", res, dep_pad, dep_err,
-      i == lines - 1 && lines < line_max ? "..." : "",
-      lines > 1 && line_max > 1 ? "\n" : "", ""
-  );}
-  return res;
+    CSR_strbuf_add(&res, dep_pad);
+    CSR_strbuf_add(&res, dep_err);
+    if(i == lines - 1 && lines < line_max) CSR_strbuf_add(&res, "...");
+    if(lines > 1 && line_max > 1) CSR_strbuf_add(&res, "\n");
+  }
+  return res.str;
 }
 SEXP ALIKEC_pad_ext(SEXP obj, SEXP lines, SEXP pad) {
   struct VALC_settings set = VALC_settings_init();
@@ -359,6 +571,93 @@ int ALIKEC_syntactic_names(SEXP lang) {
 SEXP ALIKEC_syntactic_names_exp(SEXP lang) {
   return ScalarLogical(ALIKEC_syntactic_names(lang));
 }
+/*
+ * Resolve `getOption("width")`, which we only read once per top level call if
+ * the entry point provided somewhere to store it in `set.width_opt`.
+ */
+static int ALIKEC_width(int width, struct VALC_settings set) {
+  if(width < 0) {
+    if(set.width_opt && *set.width_opt > 0) return *set.width_opt;
+    width = asInteger(ALIKEC_getopt("width"));
+    if(width <= 0 || width == NA_INTEGER) width = 80;
+    if(set.width_opt) *set.width_opt = width;
+  }
+  if(width <= 0 || width == NA_INTEGER) width = 80;
+  return width;
+}
+/*
+ * Cache for `ALIKEC_pad_or_quote` and `ALIKEC_deparse_chr`
+ *
+ * The same language (e.g. validation tokens) is often padded or quoted, or
+ * deparsed, many times over, so we keep the results keyed on the language and
+ * the parameters that affect the output.  Multi line `ALIKEC_pad_or_quote`
+ * results depend on the `prompt` and `continue` options so are not cached.
+ *
+ * R only allows weak references keyed on environments and external pointers so
+ * we cannot weakly reference the language directly.  Instead the cache is
+ * direct mapped on the address of the language, and each entry holds a copy of
+ * the language that we check against with `identical`.  This way the cache
+ * never keeps the caller's language alive, is bounded in size, and can never
+ * return a stale result should the address be re-used.  Each entry is a list
+ * with the language copy, the kind of result (see ALIKEC_LANG_CACHE_*), width,
+ * syntactic, and nchar.max parameters, and the result.
+ */
+#define ALIKEC_LANG_CACHE_SIZE 256
+#define ALIKEC_LANG_CACHE_PQ 0     // `ALIKEC_pad_or_quote`
+#define ALIKEC_LANG_CACHE_DEP 1    // `ALIKEC_deparse_chr`
+
+static SEXP ALIKEC_lang_cache = NULL;
+
+static R_xlen_t ALIKEC_lang_cache_slot(
+  SEXP lang, int kind, int width, int syntactic
+) {
+  uintptr_t hash = ((uintptr_t) lang >> 3) * 31 + (uintptr_t) width;
+  hash = hash * 31 + (uintptr_t) (syntactic + 1);
+  hash = hash * 31 + (uintptr_t) kind;
+  return (R_xlen_t) (hash % ALIKEC_LANG_CACHE_SIZE);
+}
+static SEXP ALIKEC_lang_cache_get(
+  SEXP lang, int kind, int width, int syntactic, struct VALC_settings set
+) {
+  if(!ALIKEC_lang_cache) return R_NilValue;
+  SEXP entry = VECTOR_ELT(
+    ALIKEC_lang_cache, ALIKEC_lang_cache_slot(lang, kind, width, syntactic)
+  );
+  if(entry == R_NilValue) return R_NilValue;
+
+  int * params = INTEGER(VECTOR_ELT(entry, 1));
+  if(
+    params[0] != kind || params[1] != width || params[2] != syntactic ||
+    params[3] != (int) set.nchar_max ||
+    !R_compute_identical(lang, VECTOR_ELT(entry, 0), 16)
+  )
+    return R_NilValue;
+  return VECTOR_ELT(entry, 2);
+}
+static void ALIKEC_lang_cache_set(
+  SEXP lang, int kind, int width, int syntactic, struct VALC_settings set,
+  const char * chr
+) {
+  if(set.nchar_max > INT_MAX) return;
+  if(!ALIKEC_lang_cache) {
+    ALIKEC_lang_cache = allocVector(VECSXP, ALIKEC_LANG_CACHE_SIZE);
+    R_PreserveObject(ALIKEC_lang_cache);
+  }
+  SEXP entry = PROTECT(allocVector(VECSXP, 3));
+  SET_VECTOR_ELT(entry, 0, duplicate(lang));
+  SEXP params = allocVector(INTSXP, 4);
+  SET_VECTOR_ELT(entry, 1, params);
+  INTEGER(params)[0] = kind;
+  INTEGER(params)[1] = width;
+  INTEGER(params)[2] = syntactic;
+  INTEGER(params)[3] = (int) set.nchar_max;
+  SET_VECTOR_ELT(entry, 2, mkChar(chr));
+  SET_VECTOR_ELT(
+    ALIKEC_lang_cache, ALIKEC_lang_cache_slot(lang, kind, width, syntactic),
+    entry
+  );
+  UNPROTECT(1);
+}
 /*
  * Deparse a call and quote it, or if it is too long to quote, put on it's own
  * lines and offset otherwise
@@ -376,33 +675,44 @@ SEXP ALIKEC_syntactic_names_exp(SEXP lang) {
 struct ALIKEC_pad_quote_res ALIKEC_pad_or_quote(
   SEXP lang, int width, int syntactic, struct VALC_settings set
 ) {
-  switch(syntactic) {
-    case -1: syntactic = ALIKEC_syntactic_names(lang); break;
-    case 0:
-    case 1: break;
-    default: {
-      // nocov start
-      error("Internal Error: unexpected `syntactic` value; contat maintainer");
-      // nocov end
-    }
+  if(syntactic < -1 || syntactic > 1) {
+    // nocov start
+    error("Internal Error: unexpected `syntactic` value; contat maintainer");
+    // nocov end
   }
   if(width != set.width)
     // nocov start
     error("Internal Error: mismatched width values; contact maintainer.");
     // nocov end
 
-  if(width < 0) width = asInteger(ALIKEC_getopt("width"));
-  if(width <= 0 || width == NA_INTEGER) width = 80;
+  width = ALIKEC_width(width, set);
+
+  SEXP cached =
+    ALIKEC_lang_cache_get(lang, ALIKEC_LANG_CACHE_PQ, width, syntactic, set);
+  if(cached != R_NilValue) {
+    // Copy as the cache entry could be evicted while the result is in use
+
+    return (struct ALIKEC_pad_quote_res) {
+      .chr=CSR_strmcpy(CHAR(cached), set.nchar_max), .multi_line=0
+    };
+  }
+  int syntactic_in = syntactic;
   SEXP lang_dep = PROTECT(ALIKEC_deparse_width(lang, width));
 
   // Handle the different deparse scenarios
 
   int multi_line = 1;
-  const char * dep_chr = CHAR(asChar(lang_dep));
+  SEXP dep_chrsxp = asChar(lang_dep);
+  const char * dep_chr = CHAR(dep_chrsxp);
+
+  // Compare display width rather than bytes so wide or multi-byte characters
+  // are not mistaken for long lines
 
   if(XLENGTH(lang_dep) == 1) {
-    size_t dep_chr_len = CSR_strmlen(dep_chr, set.nchar_max);
-    if(width > 2 && dep_chr_len <= (size_t) (width - 2)) multi_line = 0;
+    size_t dep_chr_width = CSR_display_width(
+      dep_chr, set.nchar_max, CSR_chr_is_utf8(dep_chrsxp)
+    );
+    if(width > 2 && dep_chr_width <= (size_t) (width - 2)) multi_line = 0;
   }
   const char * call_char, * call_pre = "", * call_post = "";
   if(multi_line) {
@@ -412,8 +722,10 @@ struct ALIKEC_pad_quote_res ALIKEC_pad_or_quote(
   } else {
     // In case there are non syntactic names in the call, use braces instead of
     // backticks to avoid possible confusion; maybe it would better to just scan
-    // the deparsed string for backticks?
+    // the deparsed string for backticks?  We only need to check the names for
+    // single line results, which are cached, so each language is scanned once.
 
+    if(syntactic == -1) syntactic = ALIKEC_syntactic_names(lang);
     if(syntactic) {
       call_pre = "`";
       call_post = "`";
@@ -423,12 +735,18 @@ struct ALIKEC_pad_quote_res ALIKEC_pad_or_quote(
     }
     call_char = dep_chr;
   }
+  struct CSR_strbuf res = CSR_strbuf_init(set.nchar_max, set.arena);
+  CSR_strbuf_add(&res, call_pre);
+  CSR_strbuf_add(&res, call_char);
+  CSR_strbuf_add(&res, call_post);
   UNPROTECT(1);
-  const char * res = CSR_smprintf4(
-    set.nchar_max, "%s%s%s%s", call_pre, call_char, call_post, ""
-  );
+  if(!multi_line)
+    ALIKEC_lang_cache_set(
+      lang, ALIKEC_LANG_CACHE_PQ, width, syntactic_in, set, res.str
+    );
+
   return (struct ALIKEC_pad_quote_res) {
-    .chr=res, .multi_line=multi_line
+    .chr=res.str, .multi_line=multi_line
   };
 }
 /*
@@ -444,7 +762,8 @@ SEXP ALIKEC_pad_or_quote_ext(SEXP lang, SEXP width, SEXP syntactic) {
 }
 
 /*
-deparse into character
+deparse into character; results for calls are cached (see
+`ALIKEC_lang_cache_get`) as they don't depend on any options
 
 @param width_cutoff to use as `width.cutoff` param to `deparse`
 @param lines to use as `lines` arg to ALIKEC_pad
@@ -452,11 +771,28 @@ deparse into character
 const char * ALIKEC_deparse_chr(
   SEXP obj, int width_cutoff, struct VALC_settings set
 ) {
+  int cache = TYPEOF(obj) == LANGSXP;
+  if(cache) {
+    SEXP cached = ALIKEC_lang_cache_get(
+      obj, ALIKEC_LANG_CACHE_DEP, width_cutoff, 0, set
+    );
+    // Copy as the cache entry could be evicted while the result is in use
+
+    if(cached != R_NilValue) return CSR_strmcpy(CHAR(cached), set.nchar_max);
+  }
   SEXP res_dep = PROTECT(ALIKEC_deparse_core(obj, width_cutoff));
   const char * res = ALIKEC_pad(res_dep, -1, 0, set);
   UNPROTECT(1);
+  if(cache)
+    ALIKEC_lang_cache_set(
+      obj, ALIKEC_LANG_CACHE_DEP, width_cutoff, 0, set, res
+    );
   return res;
 }
+SEXP ALIKEC_deparse_chr_ext(SEXP obj, SEXP width_cutoff) {
+  struct VALC_settings set = VALC_settings_init();
+  return mkString(ALIKEC_deparse_chr(obj, asInteger(width_cutoff), set));
+}
 
 /*
 Simplified version of R's internal findFun
@@ -510,15 +846,19 @@ SEXP ALIKEC_findFun_ext(SEXP symbol, SEXP rho) {
 struct ALIKEC_tar_cur_strings ALIKEC_get_res_strings(
   struct ALIKEC_res_strings strings, struct VALC_settings set
 ) {
-  const char * tar_str = CSR_smprintf4(
-    set.nchar_max, strings.target[0], strings.target[1],
-    strings.target[2], strings.target[3], strings.target[4]
+  struct CSR_strbuf tar_str = CSR_strbuf_init(set.nchar_max, set.arena);
+  struct CSR_strbuf cur_str = CSR_strbuf_init(set.nchar_max, set.arena);
+  CSR_strbuf_addf(
+    &tar_str, strings.target[0], strings.target[1], strings.target[2],
+    strings.target[3], strings.target[4]
   );
-  const char * cur_str = CSR_smprintf4(
-    set.nchar_max, strings.current[0], strings.current[1],
-    strings.current[2], strings.current[3], strings.current[4]
+  CSR_strbuf_addf(
+    &cur_str, strings.current[0], strings.current[1], strings.current[2],
+    strings.current[3], strings.current[4]
   );
-  return (struct ALIKEC_tar_cur_strings) {.target=tar_str, .current=cur_str};
+  return (struct ALIKEC_tar_cur_strings) {
+    .target=tar_str.str, .current=cur_str.str
+  };
 }
 /*
 Convert convention of zero length string == TRUE to SEXP
@@ -548,18 +888,20 @@ SEXP ALIKEC_res_as_string(
 
     const char * extra_blank = "";
     if(!call_res.multi_line) extra_blank = " ";
+    struct CSR_strbuf res_buf = CSR_strbuf_init(set.nchar_max, set.arena);
     if(strings_pasted.target[0] && strings_pasted.current[0]) {
-      res_str = CSR_smprintf6(
-        set.nchar_max,
-        "%s%sshould %s %s (%s %s)",
+      CSR_strbuf_addf(
+        &res_buf, "%s%sshould %s %s (%s %s)",
         call_chr, extra_blank, res.dat.strings.tar_pre, strings_pasted.target,
         res.dat.strings.cur_pre, strings_pasted.current
       );
+      res_str = res_buf.str;
     } else if (res.dat.strings.target[0]) {
-      res_str = CSR_smprintf4(
-        set.nchar_max, "%s%sshould %s %s", call_chr, extra_blank,
+      CSR_strbuf_addf(
+        &res_buf, "%s%sshould %s %s", call_chr, extra_blank,
         res.dat.strings.tar_pre, strings_pasted.target
       );
+      res_str = res_buf.str;
     }
   } else
     error("Internal Error: res_as_string only works with fail res."); // nocov
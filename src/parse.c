@@ -141,6 +141,7 @@ SEXP VALC_sub_symbol(
   SEXP lang, struct VALC_settings set, struct track_hash * track_hash,
   SEXP arg_tag
 ) {
+  VALC_PROF_START(prof_start);
   int check_arg_tag = TYPEOF(arg_tag) == SYMSXP;
   SEXP rho = set.env;
 
@@ -189,10 +190,11 @@ SEXP VALC_sub_symbol(
     if(!var_found_resolves_symbol) break;
   }
   UNPROTECT(1);
+  VALC_PROF_END(VALC_PROF_SUB_SYMBOL, prof_start);
   return(lang);
 }
 SEXP VALC_sub_symbol_ext(SEXP lang, SEXP rho) {
-  struct track_hash * track_hash = VALC_create_track_hash(64);
+  struct track_hash * track_hash = VALC_create_track_hash(64, NULL);
   struct VALC_settings set = VALC_settings_vet(R_NilValue, rho);
   return VALC_sub_symbol(lang, set, track_hash, R_NilValue);
 }
@@ -206,6 +208,7 @@ SEXP VALC_sub_symbol_ext(SEXP lang, SEXP rho) {
 SEXP VALC_parse(
   SEXP lang, SEXP var_name, struct VALC_settings set, SEXP arg_tag
 ) {
+  VALC_PROF_START(prof_start);
   SEXP lang_cpy, lang2_cpy, res, res_vec, rem_res;
   int mode;
 
@@ -227,9 +230,9 @@ SEXP VALC_parse(
   // more complicated.
 
   struct track_hash * track_hash =
-    VALC_create_track_hash(set.track_hash_content_size);
+    VALC_create_track_hash(set.track_hash_content_size, set.arena);
   struct track_hash * track_hash2 =
-    VALC_create_track_hash(set.track_hash_content_size);
+    VALC_create_track_hash(set.track_hash_content_size, set.arena);
 
   // Replace any variables to language objects with language, though first check
   // that we don't already have the `.`, although that would be odd even before
@@ -264,6 +267,7 @@ SEXP VALC_parse(
   SET_VECTOR_ELT(res_vec, 1, res);
   SET_VECTOR_ELT(res_vec, 2, lang2_cpy);
   UNPROTECT(9);
+  VALC_PROF_END(VALC_PROF_PARSE, prof_start);
   return(res_vec);
 }
 SEXP VALC_parse_ext(SEXP lang, SEXP var_name, SEXP rho) {
@@ -151,17 +151,19 @@ static void locate (pfHashTable *tbl, const char *key,
 //   we use this one.
 // DEVNOTE: Should we switch this to strmcpy?
 
-static char *dupstr (const char *str) {
-    char *newstr = R_alloc (strlen (str) + 1, sizeof(char));
+static char *dupstr (struct VALC_arena *arena, const char *str) {
+    char *newstr = VALC_arena_alloc (arena, strlen (str) + 1, sizeof(char));
     if (newstr != NULL)
         strcpy (newstr, str);
     return newstr;
 }
 
 // Create a hash table, giving only the hashing
-//   function.
+//   function and the arena to allocate from.
 
-pfHashTable *pfHashCreate (uint32_t (*fn)(const char *)) {
+pfHashTable *pfHashCreate (
+    uint32_t (*fn)(const char *), struct VALC_arena *arena
+) {
     // Use default if none given, and get number
     //   of entries allowed.
 
@@ -172,13 +174,14 @@ pfHashTable *pfHashCreate (uint32_t (*fn)(const char *)) {
     // Allocate the hash table, including entries
     //   for lists of nodes.
 
-    pfHashTable *tbl = (void *) R_alloc (1, sizeof (pfHashTable)
+    pfHashTable *tbl = VALC_arena_alloc (arena, 1, sizeof (pfHashTable)
         + numEntries * sizeof (pfHashNode*));
     if (tbl == NULL) return NULL;  // nocov
 
     // Store function and set hash entries to empty.
 
     tbl->fn = fn;
+    tbl->arena = arena;
 
     for (uint32_t i = 0; i < numEntries; i++)
         tbl->lookup[i] = NULL;
@@ -229,7 +232,11 @@ int pfHashSet (pfHashTable *tbl, const char *key, const char *data) {
     locate (tbl, key, &entry, &prev, &node);
 
     if (node != NULL) {
-        char *newdata = dupstr (data);
+        // Don't re-allocate if unchanged; the tracking hash relies on this to
+        // avoid pointing existing nodes to memory that a reset could release
+        if (!strcmp (node->data, data))
+            return 1;
+        char *newdata = dupstr (tbl->arena, data);
         if (newdata == NULL)
             return -1;  // nocov
         // free (node->data);
@@ -237,12 +244,12 @@ int pfHashSet (pfHashTable *tbl, const char *key, const char *data) {
         return 1;  // this used to be zero
     }
 
-    node = (void *) R_alloc (1, sizeof (pfHashNode));
+    node = VALC_arena_alloc (tbl->arena, 1, sizeof (pfHashNode));
     if (node == NULL)
         return -1;  // nocov
 
-    node->key = dupstr (key);
-    node->data = dupstr (data);
+    node->key = dupstr (tbl->arena, key);
+    node->data = dupstr (tbl->arena, data);
     if ((node->key == NULL) || (node->data == NULL)) {
         // free (node->key);
         // free (node->data);
@@ -330,7 +337,7 @@ void pfHashDebug (pfHashTable *tbl, char *desc) {
  */
 
 SEXP pfHashTest(SEXP keys, SEXP values) {
-  pfHashTable * hash = pfHashCreate(NULL);
+  pfHashTable * hash = pfHashCreate(NULL, NULL);
 
   if(TYPEOF(keys) != STRSXP) error("Argument `keys` must be a string");
   if(TYPEOF(values) != STRSXP) error("Argument `values` must be a string");
@@ -363,7 +370,7 @@ SEXP pfHashTest(SEXP keys, SEXP values) {
  */
 
 SEXP pfHashTest2(SEXP keys, SEXP add) {
-  pfHashTable * hash = pfHashCreate(NULL);
+  pfHashTable * hash = pfHashCreate(NULL, NULL);
 
   if(TYPEOF(keys) != STRSXP)
     error("Internal Error: `keys` must be a string");  // nocov
@@ -36,6 +36,7 @@ Go to <https://www.r-project.org/Licenses/GPL-2> for a copy of the license.
 #include <Rinternals.h>
 #include <ctype.h>
 #include <stdint.h>
+#include "arena.h"
 
 #ifndef _PFHASH_H
 #define _PFHASH_H
@@ -49,10 +50,11 @@ Go to <https://www.r-project.org/Licenses/GPL-2> for a copy of the license.
 
     typedef struct {
         uint32_t (*fn) (const char *);
+        struct VALC_arena *arena;  // NULL to use R_alloc
         pfHashNode *lookup[];
     } pfHashTable;
 
-    pfHashTable *pfHashCreate (uint32_t(*)(const char*));
+    pfHashTable *pfHashCreate (uint32_t(*)(const char*), struct VALC_arena*);
     // void pfHashDestroy (pfHashTable*);
     int pfHashSet (pfHashTable*,const char*,const char*);
      int pfHashDel (pfHashTable*,const char*);
@@ -0,0 +1,92 @@
+/*
+Copyright (C) 2020 Brodie Gaslam
+
+This file is part of "vetr - Trust, but Verify"
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+Go to <https://www.r-project.org/Licenses/GPL-2> for a copy of the license.
+*/
+
+#include <time.h>
+#include "profile.h"
+
+/*
+ * Hot path instrumentation, see profile.h.  Times are inclusive, so e.g. the
+ * time for `VALC_parse` includes that of the `VALC_sub_symbol` calls it makes.
+ */
+
+static const char * VALC_prof_names[VALC_PROF_N] = {
+  "parse", "sub_symbol", "eval", "alike_rec", "compare_attributes",
+  "deparse", "process_error"
+};
+static double VALC_prof_calls[VALC_PROF_N];
+static double VALC_prof_ns[VALC_PROF_N];
+
+/*
+ * We want to resolve differences of a microsecond or less, so we use the
+ * monotonic clock where it is available and fall back to `clock()` otherwise.
+ */
+uint64_t VALC_clock_ns(void) {
+#ifdef CLOCK_MONOTONIC
+  struct timespec ts;
+  if(!clock_gettime(CLOCK_MONOTONIC, &ts))
+    return (uint64_t) ts.tv_sec * 1000000000U + (uint64_t) ts.tv_nsec;
+#endif
+  return (uint64_t) ((double) clock() / CLOCKS_PER_SEC * 1e9);  // nocov
+}
+#ifdef VETR_PROFILE
+void VALC_prof_add(enum VALC_prof_stage stage, uint64_t start) {
+  VALC_prof_calls[stage]++;
+  VALC_prof_ns[stage] += (double) (VALC_clock_ns() - start);
+}
+#endif
+/*
+ * External interface to the counters, if `reset` is TRUE they are zeroed after
+ * being read.
+ *
+ * @return a list with whether profiling was compiled in, the stage names, the
+ *   call counts and the cumulative nanoseconds.
+ */
+SEXP VALC_profile(SEXP reset) {
+  if(TYPEOF(reset) != LGLSXP || XLENGTH(reset) != 1)
+    error("Argument `reset` must be TRUE or FALSE.");
+
+  SEXP res = PROTECT(allocVector(VECSXP, 4));
+  SEXP res_names = PROTECT(allocVector(STRSXP, 4));
+  SEXP stage = PROTECT(allocVector(STRSXP, VALC_PROF_N));
+  SEXP calls = PROTECT(allocVector(REALSXP, VALC_PROF_N));
+  SEXP ns = PROTECT(allocVector(REALSXP, VALC_PROF_N));
+
+  for(int i = 0; i < VALC_PROF_N; i++) {
+    SET_STRING_ELT(stage, i, mkChar(VALC_prof_names[i]));
+    REAL(calls)[i] = VALC_prof_calls[i];
+    REAL(ns)[i] = VALC_prof_ns[i];
+  }
+#ifdef VETR_PROFILE
+  SET_VECTOR_ELT(res, 0, ScalarLogical(1));
+#else
+  SET_VECTOR_ELT(res, 0, ScalarLogical(0));
+#endif
+  SET_VECTOR_ELT(res, 1, stage);
+  SET_VECTOR_ELT(res, 2, calls);
+  SET_VECTOR_ELT(res, 3, ns);
+  const char * names[4] = {"enabled", "stage", "calls", "ns"};
+  for(int i = 0; i < 4; i++) SET_STRING_ELT(res_names, i, mkChar(names[i]));
+  setAttrib(res, R_NamesSymbol, res_names);
+
+  if(asLogical(reset) == 1) {
+    for(int i = 0; i < VALC_PROF_N; i++)
+      VALC_prof_calls[i] = VALC_prof_ns[i] = 0;
+  }
+  UNPROTECT(5);
+  return res;
+}
@@ -0,0 +1,63 @@
+/*
+Copyright (C) 2020 Brodie Gaslam
+
+This file is part of "vetr - Trust, but Verify"
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+Go to <https://www.r-project.org/Licenses/GPL-2> for a copy of the license.
+*/
+
+#include <R.h>
+#include <Rinternals.h>
+#include <stdint.h>
+
+#ifndef _VETR_PROFILE_H
+#define _VETR_PROFILE_H
+
+  // Stages we instrument, keep in sync with `VALC_prof_names` in profile.c
+
+  enum VALC_prof_stage {
+    VALC_PROF_PARSE,
+    VALC_PROF_SUB_SYMBOL,
+    VALC_PROF_EVAL,
+    VALC_PROF_ALIKE_REC,
+    VALC_PROF_COMPARE_ATTR,
+    VALC_PROF_DEPARSE,
+    VALC_PROF_PROCESS_ERROR,
+    VALC_PROF_N
+  };
+  /*
+   * Instrumentation is only compiled in with `-DVETR_PROFILE`, otherwise the
+   * macros expand to nothing.  Use as:
+   *
+   *   VALC_PROF_START(prof_start);
+   *   ... code to time ...
+   *   VALC_PROF_END(VALC_PROF_PARSE, prof_start);
+   *
+   * Nothing is recorded if we exit between the two via a long jump.
+   */
+  #ifdef VETR_PROFILE
+    void VALC_prof_add(enum VALC_prof_stage stage, uint64_t start);
+
+    #define VALC_PROF_START(var) uint64_t var = VALC_clock_ns()
+    #define VALC_PROF_END(stage, var) VALC_prof_add((stage), (var))
+  #else
+    #define VALC_PROF_START(var)
+    #define VALC_PROF_END(stage, var)
+  #endif
+
+  // Monotonic clock in nanoseconds, for timing
+
+  uint64_t VALC_clock_ns(void);
+  SEXP VALC_profile(SEXP reset);
+
+#endif
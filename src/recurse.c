@@ -79,6 +79,63 @@ struct ALIKEC_rec_track ALIKEC_rec_ind_num(
   union ALIKEC_index_raw ind_u = {.num = ind};
   return ALIKEC_rec_ind_set(res, (struct ALIKEC_index) {ind_u, 0});
 }
+/*
+Record indices for all levels at once from the traversal stack in
+`ALIKEC_alike_rec`; `stack[0]` is the outermost level.  Equivalent to calling
+`ALIKEC_rec_ind_*` for each of the first `n` levels as we unwind.
+
+`rec.lvl` should be the level the traversal started at.
+*/
+struct ALIKEC_rec_track ALIKEC_rec_ind_stack(
+  struct ALIKEC_rec_track rec, struct ALIKEC_rec_frame * stack, size_t n
+) {
+  if(!n) return rec;
+
+  rec.lvl_max = rec.lvl + n;
+  rec.indices = (struct ALIKEC_index *)
+    R_alloc(rec.lvl_max, sizeof(struct ALIKEC_index));
+
+  for(size_t k = 0; k < n; ++k) {
+    struct ALIKEC_rec_frame frame = stack[k];
+    union ALIKEC_index_raw ind_u = {.num = frame.i + 1};
+    struct ALIKEC_index ind = {ind_u, 0};
+
+    switch(frame.type) {
+      case VECSXP:
+      case EXPRSXP: {
+        SEXP vec_names = getAttrib(frame.target, R_NamesSymbol);
+        const char * ind_name;
+        if(
+          vec_names != R_NilValue &&
+          ((ind_name = CHAR(STRING_ELT(vec_names, frame.i))))[0]
+        ) {
+          ind.ind.chr = ind_name;
+          ind.type = 1;
+        }
+        break;
+      }
+      case ENVSXP:
+        ind.ind.chr = CHAR(STRING_ELT(frame.names, frame.i));
+        ind.type = 1;
+        break;
+      case LISTSXP:
+        if(TAG(frame.tar_sub) != R_NilValue) {
+          ind.ind.chr = CHAR(asChar(PRINTNAME(TAG(frame.tar_sub))));
+          ind.type = 1;
+        }
+        break;
+      default:
+        // nocov start
+        error(
+          "Internal Error: unexpected frame type %s; contact maintainer.",
+          type2char(frame.type)
+        );
+        // nocov end
+    }
+    rec.indices[rec.lvl + k] = ind;
+  }
+  return rec;
+}
 struct ALIKEC_rec_track ALIKEC_rec_track_init() {
   return (struct ALIKEC_rec_track) {
     .lvl = 0,
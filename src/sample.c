@@ -0,0 +1,135 @@
+/*
+Copyright (C) 2020 Brodie Gaslam
+
+This file is part of "vetr - Trust, but Verify"
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+Go to <https://www.r-project.org/Licenses/GPL-2> for a copy of the license.
+*/
+
+#include "sample.h"
+#include <stdint.h>
+
+/*
+ * Sampled element checks, for vectors too large to check in full.
+ *
+ * We use our own generator (splitmix64) instead of R's so that samples are
+ * reproducible from the seed alone and don't disturb `.Random.seed`.
+ */
+
+static uint64_t VALC_sample_rand(uint64_t * state) {
+  uint64_t z = (*state += 0x9E3779B97F4A7C15ULL);
+  z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+  z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+  return z ^ (z >> 31);
+}
+/*
+ * Choose a sample of at most `k` of the `n` elements of a vector.  If `n` is
+ * not greater than `k` the sample is the whole vector.
+ */
+struct VALC_sample VALC_sample_init(
+  R_xlen_t n, R_xlen_t k, int seed, struct VALC_arena * arena
+) {
+  if(n < 0 || k < 0)
+    error("Internal Error: negative sample size; contact maintainer."); // nocov
+
+  struct VALC_sample res = {.n_blocks = 1, .block_size = n, .starts = NULL};
+  if(n <= k || n < 2) {
+    res.starts = VALC_arena_alloc(arena, 1, sizeof(R_xlen_t));
+    res.starts[0] = 0;
+    return res;
+  }
+  if(k < 2) k = 2;   // need room for the first and last blocks
+
+  res.block_size = k >= 2 * VALC_SAMPLE_BLOCK ? VALC_SAMPLE_BLOCK : k / 2;
+  res.n_blocks = k / res.block_size;
+  res.starts = VALC_arena_alloc(arena, res.n_blocks, sizeof(R_xlen_t));
+
+  // Since n > k >= n_blocks * block_size, every stratum is at least
+  // block_size long so blocks never overlap
+
+  double width = (double) n / res.n_blocks;
+  uint64_t state = (uint64_t) seed;
+  R_xlen_t last = res.n_blocks - 1;
+
+  res.starts[0] = 0;
+  res.starts[last] = n - res.block_size;
+  for(R_xlen_t j = 1; j < last; ++j) {
+    R_xlen_t lo = (R_xlen_t) (j * width);
+    R_xlen_t hi = (R_xlen_t) ((j + 1) * width);
+    uint64_t span = (uint64_t) (hi - lo - res.block_size + 1);
+    res.starts[j] = lo + (R_xlen_t) (VALC_sample_rand(&state) % span);
+  }
+  return res;
+}
+/*
+ * Number of elements in the sample
+ */
+R_xlen_t VALC_sample_len(struct VALC_sample sample) {
+  return sample.n_blocks * sample.block_size;
+}
+/*
+ * Index in the original vector of element `i` of the sample
+ */
+R_xlen_t VALC_sample_index(struct VALC_sample sample, R_xlen_t i) {
+  return sample.starts[i / sample.block_size] + i % sample.block_size;
+}
+/*
+ * Copy the sampled elements of an atomic vector into a new vector of the same
+ * type.  Attributes are not copied.
+ */
+SEXP VALC_sample_vec(SEXP x, struct VALC_sample sample) {
+  SEXPTYPE x_type = TYPEOF(x);
+  R_xlen_t len = VALC_sample_len(sample), block = sample.block_size;
+  SEXP res = PROTECT(allocVector(x_type, len));
+  size_t size = 0;
+  char * from = NULL, * to = NULL;
+
+  switch(x_type) {
+    case LGLSXP:
+    case INTSXP:
+      size = sizeof(int);
+      from = (char *) INTEGER(x); to = (char *) INTEGER(res);
+      break;
+    case REALSXP:
+      size = sizeof(double);
+      from = (char *) REAL(x); to = (char *) REAL(res);
+      break;
+    case CPLXSXP:
+      size = sizeof(Rcomplex);
+      from = (char *) COMPLEX(x); to = (char *) COMPLEX(res);
+      break;
+    case RAWSXP:
+      size = sizeof(Rbyte);
+      from = (char *) RAW(x); to = (char *) RAW(res);
+      break;
+    case STRSXP:
+      for(R_xlen_t i = 0; i < len; ++i)
+        SET_STRING_ELT(res, i, STRING_ELT(x, VALC_sample_index(sample, i)));
+      break;
+    default:
+      // nocov start
+      error(
+        "Internal Error: cannot sample type %s; contact maintainer.",
+        type2char(x_type)
+      );
+      // nocov end
+  }
+  if(size) {
+    for(R_xlen_t j = 0; j < sample.n_blocks; ++j)
+      memcpy(
+        to + j * block * size, from + sample.starts[j] * size, block * size
+      );
+  }
+  UNPROTECT(1);
+  return res;
+}
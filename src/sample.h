@@ -0,0 +1,50 @@
+/*
+Copyright (C) 2020 Brodie Gaslam
+
+This file is part of "vetr - Trust, but Verify"
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+Go to <https://www.r-project.org/Licenses/GPL-2> for a copy of the license.
+*/
+
+#include <R.h>
+#include <Rinternals.h>
+#include "arena.h"
+
+#ifndef _VETR_SAMPLE_H
+#define _VETR_SAMPLE_H
+
+  // Number of contiguous elements in each block of a sample
+
+  #define VALC_SAMPLE_BLOCK 64
+
+  /*
+   * A deterministic stratified sample of the elements of a vector, made of
+   * `n_blocks` runs of `block_size` contiguous elements.  The vector is split
+   * into `n_blocks` equal strata with one block in each; the first and last
+   * blocks are always the first and last elements of the vector, and the
+   * others are at positions within their strata that depend only on the seed.
+   */
+  struct VALC_sample {
+    R_xlen_t n_blocks;
+    R_xlen_t block_size;
+    R_xlen_t * starts;     // index of the first element of each block
+  };
+
+  struct VALC_sample VALC_sample_init(
+    R_xlen_t n, R_xlen_t k, int seed, struct VALC_arena * arena
+  );
+  R_xlen_t VALC_sample_len(struct VALC_sample sample);
+  R_xlen_t VALC_sample_index(struct VALC_sample sample, R_xlen_t i);
+  SEXP VALC_sample_vec(SEXP x, struct VALC_sample sample);
+
+#endif
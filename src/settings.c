@@ -34,13 +34,22 @@ struct VALC_settings VALC_settings_init() {
     .in_attr = 0,
     .env = R_NilValue,
     .width = -1,
+    .width_opt = NULL,
     .env_depth_max = 65535L,
     .symb_sub_depth_max = 65535L,
     .nchar_max = 65535L,
     .symb_size_max = 15000L,
     .track_hash_content_size = 63L,
     .result_list_size_init = 64L,
-    .result_list_size_max = 2048L
+    .result_list_size_max = 2048L,
+    .stats_sample = 0,
+    .vetr_sample = 1,
+    .elt_sample = 0,
+    .elt_seed = 1,
+    .audit = 0,
+    .memo = 0,
+    .df_mode = 0,
+    .arena = NULL
   };
 }
 /*
@@ -77,6 +86,10 @@ static long VALC_is_scalar_int(
     );
   return x_int;
 }
+// Number of elements in the list produced by `vetr_settings`
+
+static const R_xlen_t VALC_set_len = 23;
+
 /*
  * Convert input setting list into settings structure, validating
  * along the way
@@ -87,7 +100,7 @@ static long VALC_is_scalar_int(
 
 struct VALC_settings VALC_settings_vet(SEXP set_list, SEXP env) {
   struct VALC_settings settings = VALC_settings_init();
-  R_xlen_t set_len = 16;
+  R_xlen_t set_len = VALC_set_len;
 
   if(TYPEOF(set_list) == VECSXP) {
     if(xlength(set_list) != set_len) {
@@ -109,7 +122,9 @@ struct VALC_settings VALC_settings_vet(SEXP set_list, SEXP env) {
       "suppress.warnings", "fuzzy.int.max.len",
       "width", "env.depth.max", "symb.sub.depth.max", "symb.size.max",
       "nchar.max", "track.hash.content.size", "env",
-      "result.list.size.init", "result.list.size.max"
+      "result.list.size.init", "result.list.size.max", "stats.sample",
+      "audit", "vetr.sample", "elt.sample", "elt.seed", "memo",
+      "df.mode"
     };
     SEXP set_names_def_sxp = PROTECT(allocVector(STRSXP, set_len));
     for(R_xlen_t i = 0; i < set_len; ++i) {
@@ -189,6 +204,36 @@ struct VALC_settings VALC_settings_vet(SEXP set_list, SEXP env) {
     settings.result_list_size_max = VALC_is_scalar_int(
       VECTOR_ELT(set_list, 15), "result.list.size.max", 1, INT_MAX - 1
     );
+    settings.stats_sample = VALC_is_scalar_int(
+      VECTOR_ELT(set_list, 16), "stats.sample", 0, INT_MAX
+    );
+    SEXP audit = VECTOR_ELT(set_list, 17);
+    if(
+      TYPEOF(audit) != LGLSXP || xlength(audit) != 1 ||
+      asInteger(audit) == NA_LOGICAL
+    ) {
+      error("`vet/vetr` usage error: setting `audit` must be TRUE or FALSE");
+    }
+    settings.audit = asLogical(audit);
+    settings.vetr_sample = VALC_is_scalar_int(
+      VECTOR_ELT(set_list, 18), "vetr.sample", 1, INT_MAX
+    );
+    settings.elt_sample = VALC_is_scalar_int(
+      VECTOR_ELT(set_list, 19), "elt.sample", 0, INT_MAX
+    );
+    settings.elt_seed = VALC_is_scalar_int(
+      VECTOR_ELT(set_list, 20), "elt.seed", INT_MIN + 1, INT_MAX
+    );
+    SEXP memo = VECTOR_ELT(set_list, 21);
+    if(
+      TYPEOF(memo) != LGLSXP || xlength(memo) != 1 ||
+      asInteger(memo) == NA_LOGICAL
+    ) {
+      error("`vet/vetr` usage error: setting `memo` must be TRUE or FALSE");
+    }
+    settings.memo = asLogical(memo);
+    settings.df_mode =
+      VALC_is_scalar_int(VECTOR_ELT(set_list, 22), "df.mode", 0, 2);
   } else if (set_list != R_NilValue) {
     error(
       "%s (is %s).",
@@ -203,3 +248,24 @@ struct VALC_settings VALC_settings_vet(SEXP set_list, SEXP env) {
 
   return settings;
 }
+/*
+ * Retrieve only the sampling settings, for use by `vetr` before it has decided
+ * whether to validate a call, at which point `VALC_settings_vet` is too
+ * expensive.  Only the sampling values are checked; anything else wrong with
+ * `set_list` is caught by `VALC_settings_vet` the first time a call is
+ * validated, which is always the first call.
+ */
+void VALC_settings_sampling(
+  SEXP set_list, int * vetr_sample, int * stats_sample
+) {
+  *vetr_sample = 1;
+  *stats_sample = 0;
+  if(TYPEOF(set_list) == VECSXP && xlength(set_list) == VALC_set_len) {
+    *stats_sample = VALC_is_scalar_int(
+      VECTOR_ELT(set_list, 16), "stats.sample", 0, INT_MAX
+    );
+    *vetr_sample = VALC_is_scalar_int(
+      VECTOR_ELT(set_list, 18), "vetr.sample", 1, INT_MAX
+    );
+  }
+}
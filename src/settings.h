@@ -17,6 +17,7 @@ Go to <https://www.r-project.org/Licenses/GPL-2> for a copy of the license.
 */
 
 #include <Rinternals.h>
+#include "arena.h"
 
 #ifndef _VETR_SET_H
 #define _VETR_SET_H
@@ -41,6 +42,11 @@ Go to <https://www.r-project.org/Licenses/GPL-2> for a copy of the license.
 
     int width;      // Tell alike what screen width to assume
 
+    // internal, where to keep `getOption("width")` once read so we only read
+    // it once per top level call, NULL to read it every time it is needed
+
+    int * width_opt;
+
     // what env to look for functions to match call in, substitute, etc, used
     // both by alike and by vet funs
 
@@ -56,8 +62,46 @@ Go to <https://www.r-project.org/Licenses/GPL-2> for a copy of the license.
 
     int result_list_size_init;
     int result_list_size_max;
+
+    // Record call site statistics for 1 in `stats_sample` `vetr` calls, 0 to
+    // disable (see stats.c)
+
+    int stats_sample;
+
+    // Validate only 1 in `vetr_sample` `vetr` calls from each function
+
+    int vetr_sample;
+
+    // Check only a sample of about `elt_sample` elements of long vectors when
+    // inferring whether they are integer-like, 0 to check all (see sample.c)
+
+    int elt_sample;
+    int elt_seed;
+
+    // Record validation failures in the audit log instead of signaling an
+    // error (see audit.c)
+
+    int audit;
+
+    // Remember successful template comparisons against unmodifiable objects
+    // so they need not be repeated (see memo.c)
+
+    int memo;
+
+    // How data frame columns are matched to template columns: 0 by position,
+    // 1 by name, 2 by name allowing extra columns
+
+    int df_mode;
+
+    // internal, per-call allocator owned by the top level entry point, NULL
+    // means allocate with `R_alloc`
+
+    struct VALC_arena * arena;
   };
   struct VALC_settings VALC_settings_init();
   struct VALC_settings VALC_settings_vet(SEXP set_list, SEXP env);
+  void VALC_settings_sampling(
+    SEXP set_list, int * vetr_sample, int * stats_sample
+  );
 
 #endif
@@ -0,0 +1,196 @@
+/*
+Copyright (C) 2020 Brodie Gaslam
+
+This file is part of "vetr - Trust, but Verify"
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+Go to <https://www.r-project.org/Licenses/GPL-2> for a copy of the license.
+*/
+
+#include "validate.h"
+
+/*
+ * Per call site `vetr` statistics, enabled with the `stats.sample` setting,
+ * and also used to decide which calls to skip with the `vetr.sample` setting.
+ *
+ * Call sites are keyed on the closure `vetr` is validating the arguments of.
+ * The table is open addressed on the closure pointer, and the closures are
+ * kept in a preserved list so they cannot be collected and their address
+ * re-used while in the table.  This means functions remain alive until the
+ * stats are reset, so the table has a fixed size and call sites beyond that
+ * are only counted as dropped.
+ *
+ * Every call is counted, and one in `stats.sample` calls is timed, so the cost
+ * of a call that isn't timed is a pointer hash lookup.  Calls skipped due to
+ * `vetr.sample` are counted separately so that the fraction of calls actually
+ * validated can be reported.
+ */
+
+#define VALC_STATS_SIZE 1024       // must be a power of 2
+#define VALC_STATS_MAX  768        // max number of call sites in the table
+
+struct VALC_stats_entry {
+  double calls, skipped, fails, sampled, ns, ns_max;
+};
+static struct VALC_stats_entry VALC_stats_tab[VALC_STATS_SIZE];
+static SEXP VALC_stats_funs = NULL;     // closure for each slot
+static SEXP VALC_stats_labels = NULL;   // deparsed call head for each slot
+static int VALC_stats_n = 0;
+static double VALC_stats_dropped = 0;
+
+static void VALC_stats_init(void) {
+  VALC_stats_funs = allocVector(VECSXP, VALC_STATS_SIZE);
+  R_PreserveObject(VALC_stats_funs);
+  VALC_stats_labels = allocVector(STRSXP, VALC_STATS_SIZE);
+  R_PreserveObject(VALC_stats_labels);
+}
+/*
+ * Find, or add, the slot for `fun`, -1 if the table is full.  New slots are
+ * labeled later by `VALC_stats_label` as we don't have the call yet.
+ */
+static int VALC_stats_slot(SEXP fun) {
+  if(!VALC_stats_funs) VALC_stats_init();
+
+  size_t slot = (((uintptr_t) fun) >> 4) & (VALC_STATS_SIZE - 1);
+  while(1) {
+    SEXP slot_fun = VECTOR_ELT(VALC_stats_funs, (R_xlen_t) slot);
+    if(slot_fun == fun) return (int) slot;
+    if(slot_fun == R_NilValue) break;
+    slot = (slot + 1) & (VALC_STATS_SIZE - 1);
+  }
+  if(VALC_stats_n >= VALC_STATS_MAX) {
+    VALC_stats_dropped++;
+    return -1;
+  }
+  SET_VECTOR_ELT(VALC_stats_funs, (R_xlen_t) slot, fun);
+  SET_STRING_ELT(VALC_stats_labels, (R_xlen_t) slot, NA_STRING);
+  VALC_stats_tab[slot] = (struct VALC_stats_entry) {0, 0, 0, 0, 0, 0};
+  VALC_stats_n++;
+  return (int) slot;
+}
+/*
+ * Record the start of a `vetr` call; pair with `VALC_stats_end`, which is
+ * never called if we exit with an error other than a validation failure.
+ *
+ * This is called before anything else in `vetr`, so it must be cheap.  If
+ * the `skip` member of the return value is set, the call should not be
+ * validated, and `VALC_stats_end` should not be called.  Calls from functions
+ * that don't fit in the table are never skipped.
+ */
+struct VALC_stats_call VALC_stats_start(
+  SEXP fun, int vetr_sample, int stats_sample
+) {
+  struct VALC_stats_call res =
+    {.slot = -1, .skip = 0, .sampled = 0, .start = 0};
+  if(vetr_sample < 2 && !stats_sample) return res;
+
+  res.slot = VALC_stats_slot(fun);
+  if(res.slot < 0) return res;
+
+  struct VALC_stats_entry * entry = VALC_stats_tab + res.slot;
+  if(vetr_sample > 1 && fmod(entry->calls, (double) vetr_sample)) {
+    entry->calls++;
+    entry->skipped++;
+    res.skip = 1;
+    return res;
+  }
+  if(stats_sample)
+    res.sampled =
+      !fmod(entry->calls - entry->skipped, (double) stats_sample);
+  entry->calls++;
+  if(res.sampled) res.start = VALC_clock_ns();
+  return res;
+}
+/*
+ * Label a newly added call site with the function part of the call.
+ */
+void VALC_stats_label(
+  struct VALC_stats_call call, SEXP fun_call, struct VALC_settings set
+) {
+  if(
+    call.slot < 0 || STRING_ELT(VALC_stats_labels, call.slot) != NA_STRING
+  )
+    return;
+
+  SEXP label = PROTECT(
+    mkChar(ALIKEC_deparse_oneline(CAR(fun_call), 60, 0, set))
+  );
+  SET_STRING_ELT(VALC_stats_labels, call.slot, label);
+  UNPROTECT(1);
+}
+void VALC_stats_end(struct VALC_stats_call call, int fail) {
+  if(call.slot < 0) return;
+
+  struct VALC_stats_entry * entry = VALC_stats_tab + call.slot;
+  if(fail) entry->fails++;
+  if(call.sampled) {
+    double ns = (double) (VALC_clock_ns() - call.start);
+    entry->sampled++;
+    entry->ns += ns;
+    if(ns > entry->ns_max) entry->ns_max = ns;
+  }
+}
+/*
+ * External interface to the registry, if `reset` is TRUE it is cleared after
+ * being read, which also releases the functions.
+ *
+ * @return a list with the labels, functions, counters, and the number of
+ *   calls from call sites that did not fit in the table.
+ */
+SEXP VALC_stats(SEXP reset) {
+  if(TYPEOF(reset) != LGLSXP || XLENGTH(reset) != 1)
+    error("Argument `reset` must be TRUE or FALSE.");
+
+  const char * names[10] = {
+    "call", "fun", "calls", "skipped", "fails", "sampled", "ns", "ns.max",
+    "ns.mean", "dropped"
+  };
+  SEXP res = PROTECT(allocVector(VECSXP, 10));
+  SEXP res_names = PROTECT(allocVector(STRSXP, 10));
+  for(int i = 0; i < 10; i++) {
+    SET_STRING_ELT(res_names, i, mkChar(names[i]));
+    if(i == 0) SET_VECTOR_ELT(res, i, allocVector(STRSXP, VALC_stats_n));
+    else if(i == 1) SET_VECTOR_ELT(res, i, allocVector(VECSXP, VALC_stats_n));
+    else if(i < 9) SET_VECTOR_ELT(res, i, allocVector(REALSXP, VALC_stats_n));
+  }
+  SET_VECTOR_ELT(res, 9, ScalarReal(VALC_stats_dropped));
+  setAttrib(res, R_NamesSymbol, res_names);
+
+  int j = 0;
+  for(int i = 0; i < VALC_STATS_SIZE && VALC_stats_funs; i++) {
+    if(VECTOR_ELT(VALC_stats_funs, i) == R_NilValue) continue;
+    if(j >= VALC_stats_n)
+      // nocov start
+      error("Internal Error: stats table corrupted; contact maintainer.");
+      // nocov end
+
+    struct VALC_stats_entry entry = VALC_stats_tab[i];
+    SET_STRING_ELT(VECTOR_ELT(res, 0), j, STRING_ELT(VALC_stats_labels, i));
+    SET_VECTOR_ELT(VECTOR_ELT(res, 1), j, VECTOR_ELT(VALC_stats_funs, i));
+    double vals[7] = {
+      entry.calls, entry.skipped, entry.fails, entry.sampled, entry.ns,
+      entry.ns_max, entry.sampled ? entry.ns / entry.sampled : NA_REAL
+    };
+    for(int k = 0; k < 7; k++) REAL(VECTOR_ELT(res, k + 2))[j] = vals[k];
+    j++;
+  }
+  if(asLogical(reset) == 1 && VALC_stats_funs) {
+    for(int i = 0; i < VALC_STATS_SIZE; i++) {
+      SET_VECTOR_ELT(VALC_stats_funs, i, R_NilValue);
+      SET_STRING_ELT(VALC_stats_labels, i, NA_STRING);
+    }
+    VALC_stats_n = 0;
+    VALC_stats_dropped = 0;
+  }
+  UNPROTECT(2);
+  return res;
+}
@@ -15,66 +15,76 @@ GNU General Public License for more details.
 
 Go to <https://www.r-project.org/Licenses/GPL-2> for a copy of the license.
 */
+#include <locale.h>
 #include "cstringr.h"
 /*
- * This appears to update with `Sys.setlocale`, but super annoyingly we get a
- * CMD check note about this, so we need to resort to parsing `Sys.getlocale`
- * which seems more than suboptimal.  Oddly, mbcslocale doesn't trigger the same
- * note.
- */
-// extern Rboolean utf8locale;
-
-/*
- * Most of the functionality in this file already exists built in to R, so we
- * suggest you check out `nchar`, `substr`, etc.  This is mostly a learning
- * exercise for me.
+ * R's `utf8locale` appears to update with `Sys.setlocale`, but super annoyingly
+ * we get a CMD check note about using it.  We used to resort to evaluating
+ * `Sys.getlocale("LC_CTYPE")` every time we needed to know, but that is an R
+ * level evaluation in the middle of string processing.
  *
+ * `Sys.getlocale` just returns what the C library `setlocale` reports, so we
+ * ask it directly, which is cheap.  We keep a copy of the last locale string
+ * we saw and only re-parse it when it changes (i.e. after `Sys.setlocale`).
  */
-static int is_utf8_enc(cetype_t type) {
-  SEXP sys_getlocale = PROTECT(install("Sys.getlocale"));
-  SEXP lc_ctype = PROTECT(mkString("LC_CTYPE"));
-  SEXP loc_call = PROTECT(lang2(sys_getlocale, lc_ctype));
-
-  int err_val = 0;
-  SEXP eval_tmp = PROTECT(R_tryEval(loc_call, R_BaseEnv, &err_val));
-  if(err_val)
-    // nocov start
-    error("Internal Error: failed getting UTF8 locale; contact maintainer.");
-    // nocov end
-
-  if(TYPEOF(eval_tmp) != STRSXP && xlength(eval_tmp) != 1)
-    // nocov start
-    error("Internal Error: UTF8 locale not a string; contact maintainer.");
-    // nocov end
+// extern Rboolean utf8locale;
 
-  const char * loc_string = CHAR(asChar(eval_tmp));
+#define CSR_LOCALE_BUFF 256
 
-  // If eval_tmp produces a non-null terminated string we're screwed here...
+static char CSR_locale_last[CSR_LOCALE_BUFF] = "";
+static int CSR_locale_is_utf8 = -1;  // -1 means not computed yet
 
+static int CSR_parse_utf8_locale(const char * loc_string) {
   size_t loc_len = strlen(loc_string);
+  return loc_len >= 5 &&
+    loc_string[loc_len - 1] == '8' &&
+    loc_string[loc_len - 2] == '-' &&
+    (loc_string[loc_len - 3] == 'F' || loc_string[loc_len - 3] == 'f') &&
+    (loc_string[loc_len - 4] == 'T' || loc_string[loc_len - 4] == 't') &&
+    (loc_string[loc_len - 5] == 'U' || loc_string[loc_len - 5] == 'u');
+}
+static int CSR_utf8_locale(void) {
+  const char * loc_string = setlocale(LC_CTYPE, NULL);
+  if(!loc_string) loc_string = "";  // nocov
 
-  if(loc_len >= INT_MAX)
-    // nocov start
-    error(
-      "%s%s",
-      "Internal Error: UTF8 locale string possibly longer than INT_MAX; ",
-      "contact maintainer."
-    );
-    // nocov end
-
-  int res = type == CE_UTF8 ||
-    (
-      type == CE_NATIVE && loc_len >= 5 &&
-      loc_string[loc_len - 1] == '8' &&
-      loc_string[loc_len - 2] == '-' &&
-      (loc_string[loc_len - 3] == 'F' || loc_string[loc_len - 3] == 'f') &&
-      (loc_string[loc_len - 4] == 'T' || loc_string[loc_len - 4] == 't') &&
-      (loc_string[loc_len - 5] == 'U' || loc_string[loc_len - 5] == 'u')
-    );
+  if(CSR_locale_is_utf8 >= 0 && !strcmp(loc_string, CSR_locale_last))
+    return CSR_locale_is_utf8;
 
-  UNPROTECT(4);
+  // Locale strings too long for our buffer just get re-parsed each time
+
+  int is_utf8 = CSR_parse_utf8_locale(loc_string);
+  if(strlen(loc_string) < CSR_LOCALE_BUFF) {
+    strcpy(CSR_locale_last, loc_string);
+    CSR_locale_is_utf8 = is_utf8;
+  } else CSR_locale_is_utf8 = -1;  // nocov
+  return is_utf8;
+}
+/*
+ * For testing; with NULL reports whether the current locale is UTF-8,
+ * otherwise whether each of the locale strings in `loc` is.
+ */
+SEXP CSR_utf8_locale_ext(SEXP loc) {
+  if(loc == R_NilValue) return ScalarLogical(CSR_utf8_locale());
+  if(TYPEOF(loc) != STRSXP) error("Argument `loc` must be character or NULL");
+
+  R_xlen_t loc_len = XLENGTH(loc);
+  SEXP res = PROTECT(allocVector(LGLSXP, loc_len));
+  for(R_xlen_t i = 0; i < loc_len; ++i)
+    LOGICAL(res)[i] = CSR_parse_utf8_locale(CHAR(STRING_ELT(loc, i)));
+  UNPROTECT(1);
   return res;
 }
+/*
+ * Most of the functionality in this file already exists built in to R, so we
+ * suggest you check out `nchar`, `substr`, etc.  This is mostly a learning
+ * exercise for me.
+ *
+ * `utf8_loc` should be the result of `CSR_utf8_locale`, which callers look up
+ * once rather than for every string.
+ */
+static inline int is_utf8_enc(cetype_t type, int utf8_loc) {
+  return type == CE_UTF8 || (type == CE_NATIVE && utf8_loc);
+}
 /*
  * Computes how many bytes a character take.
  *
@@ -213,18 +223,50 @@ static inline int char_offset(unsigned const char * char_ptr, int is_bytes) {
  * or not.
  *
  * @param string a CHARSXP
+ * @param utf8_loc whether the locale is UTF-8, see `CSR_utf8_locale`
  */
-static inline unsigned const char * as_utf8_char(SEXP string) {
+static inline unsigned const char * as_utf8_char(
+  SEXP string, int utf8_loc, size_t * byte_len
+) {
   const char * char_val;
 
   cetype_t char_enc = getCharCE(string);
-  if(is_utf8_enc(char_enc) || char_enc == CE_BYTES) {
+  if(is_utf8_enc(char_enc, utf8_loc) || char_enc == CE_BYTES) {
     char_val = CHAR(string);
+    *byte_len = (size_t) LENGTH(string);
   } else {
     char_val = translateCharUTF8(string);
+    *byte_len = strlen(char_val);
   }
   return (unsigned const char *) char_val;
 }
+/*
+ * Count how many of the first `n` bytes of `str` are ASCII before the first
+ * byte with the high bit set.
+ *
+ * Most of what we process is ASCII, so rather than decode one byte at a time
+ * with `char_offset` we check two 64 bit words (16 bytes) at a time for high
+ * bits, and then finish byte by byte.  This is portable C; the compiler is free
+ * to vectorize it further.  `str` must have at least `n` readable bytes, and
+ * may not contain NULL bytes within them (CHARSXPs can't).
+ */
+static inline size_t CSR_ascii_run(unsigned const char * str, size_t n) {
+  const uint64_t high = 0x8080808080808080ULL;
+  uint64_t a, b;
+  size_t i = 0;
+
+  for(; i + 16 <= n; i += 16) {
+    memcpy(&a, str + i, 8);
+    memcpy(&b, str + i + 8, 8);
+    if((a | b) & high) break;
+  }
+  for(; i + 8 <= n; i += 8) {
+    memcpy(&a, str + i, 8);
+    if(a & high) break;
+  }
+  while(i < n && str[i] < 128) ++i;
+  return i;
+}
 /*
  * Truncates strings to specified length.
  *
@@ -270,6 +312,7 @@ SEXP CSR_strsub(SEXP string, SEXP chars, SEXP mark_trunc) {
     );
 
   SEXP res_string = PROTECT(allocVector(STRSXP, len));
+  int utf8_loc = CSR_utf8_locale();
 
   for(i = 0; i < len; ++i) {
     unsigned const char * char_start, * char_ptr;
@@ -277,7 +320,8 @@ SEXP CSR_strsub(SEXP string, SEXP chars, SEXP mark_trunc) {
 
     SEXP char_cont = STRING_ELT(string, i);
     cetype_t char_enc = getCharCE(char_cont);
-    char_start = as_utf8_char(char_cont);
+    size_t byte_len;
+    char_start = as_utf8_char(char_cont, utf8_loc, &byte_len);
 
     R_xlen_t char_count = 0;
 
@@ -294,6 +338,28 @@ SEXP CSR_strsub(SEXP string, SEXP chars, SEXP mark_trunc) {
       (char_val = *(char_ptr = (char_start + byte_count))) &&
       char_count < chars_int
     ) {
+      // ASCII fast path; skip ahead to the end of the run of ASCII characters
+      // or our character limit, and set the byte positions of the last two
+      // characters as the byte by byte loop would have.  We only do this once
+      // we're past the first two characters to keep things simple.
+
+      if(char_count > 1 && char_val < 128) {
+        size_t run = CSR_ascii_run(char_ptr, byte_len - (size_t) byte_count);
+        if(run > (size_t) (chars_int - char_count))
+          run = (size_t) (chars_int - char_count);
+        if((size_t) byte_count > INT_MAX - run)
+          // nocov start
+          error(
+            "Internal Error: string longer than INT_MAX bytes encountered."
+          );
+          // nocov end
+        byte_count_prev_prev =
+          run > 1 ? byte_count + (int) run - 2 : byte_count_prev;
+        byte_count_prev = byte_count + (int) run - 1;
+        byte_count += (int) run;
+        char_count += (R_xlen_t) run;
+        continue;
+      }
       // Keep track of the byte position two characters ago
 
       if(char_count > 1) byte_count_prev_prev = byte_count_prev;
@@ -362,6 +428,7 @@ SEXP CSR_nchar_u(SEXP string) {
 
   R_xlen_t i, len = xlength(string);
   SEXP res = PROTECT(allocVector(INTSXP, len));
+  int utf8_loc = CSR_utf8_locale();
 
   for(i = 0; i < len; ++i) {
     // It would be nice to be able to skip the STRING_ELT stuff and access the
@@ -373,12 +440,28 @@ SEXP CSR_nchar_u(SEXP string) {
 
     SEXP char_cont = STRING_ELT(string, i);
     cetype_t char_enc = getCharCE(char_cont);
-    char_start = as_utf8_char(char_cont);
+    size_t byte_len;
+    char_start = as_utf8_char(char_cont, utf8_loc, &byte_len);
 
     int byte_count = 0, char_count = 0;
     int too_long = 0; // track if any strings longer than INT_MAX
 
     while((char_val = *(char_ptr = (char_start + byte_count)))) {
+      // ASCII fast path, each byte is one character
+
+      if(char_val < 128) {
+        size_t run = CSR_ascii_run(char_ptr, byte_len - (size_t) byte_count);
+        if((size_t) byte_count > INT_MAX - run) {
+          // nocov start
+          too_long = 1;
+          warning("Some elements longer than INT_MAX, return NA for those.");
+          break;
+          // nocov end
+        }
+        byte_count += (int) run;
+        char_count += (int) run;
+        continue;
+      }
       int byte_off = abs(char_offset(char_ptr, char_enc == CE_BYTES));
       if((byte_count > INT_MAX - byte_off) && !too_long) {
         // nocov start
@@ -418,11 +501,19 @@ SEXP CSR_char_offsets(SEXP string) {
 
   SEXP chr_cont = STRING_ELT(string, 0);
   cetype_t char_enc = getCharCE(chr_cont);
-  char_start = as_utf8_char(chr_cont);
+  size_t byte_len;
+  char_start = as_utf8_char(chr_cont, CSR_utf8_locale(), &byte_len);
 
   int byte_count = 0, char_count = 0;
 
   while((char_val = *(char_ptr = (char_start + byte_count)))) {
+    if(char_val < 128) {
+      // ASCII fast path
+      size_t run = CSR_ascii_run(char_ptr, byte_len - (size_t) byte_count);
+      for(size_t j = 0; j < run; ++j) char_offs[char_count++] = 1;
+      byte_count += (int) run;
+      continue;
+    }
     int byte_off = char_offset(char_ptr, char_enc == CE_BYTES);
     if((byte_count > INT_MAX - abs(byte_off))) {
       // nocov start
@@ -439,3 +530,134 @@ SEXP CSR_char_offsets(SEXP string) {
   UNPROTECT(1);
   return(res);
 }
+/*
+ * Display width in columns of UTF-8 strings.
+ *
+ * Widths are looked up in the two level table in `cstringr-width.h`, which is
+ * generated from the intervals in `extra/wcwidth.c` (see
+ * `extra/wcwidth-table.c`).  East Asian wide and full-width characters count
+ * as two columns, combining and other zero width characters as none.  Control
+ * characters and bytes that are not part of a valid UTF-8 sequence count as
+ * one column so that for ASCII, or when `utf8` is 0, the width is the same as
+ * the byte count.
+ */
+#include "cstringr-width.h"
+
+static inline int CSR_cp_width(unsigned const char * ptr, int byte_off) {
+  unsigned int cp;
+  switch(byte_off) {
+    case 2:
+      cp = (ptr[0] & 0x1FU) << 6 | (ptr[1] & 0x3FU);
+      break;
+    case 3:
+      cp = (ptr[0] & 0x0FU) << 12 | (ptr[1] & 0x3FU) << 6 | (ptr[2] & 0x3FU);
+      break;
+    case 4:
+      cp = (ptr[0] & 0x07U) << 18 | (ptr[1] & 0x3FU) << 12 |
+        (ptr[2] & 0x3FU) << 6 | (ptr[3] & 0x3FU);
+      break;
+    default:
+      return 1;
+  }
+  if(cp >= CSR_WIDTH_CP_MAX) return 1;  // nocov, can't be valid UTF-8
+  return
+    (CSR_width_leaf[CSR_width_index[cp >> 8]][(cp & 0xFFU) >> 2] >>
+      ((cp & 3U) * 2)) & 3;
+}
+/*
+ * Scan up to `maxlen` bytes of `str`, stopping before the first character that
+ * would take the width over `width_max`.
+ *
+ * @param bytes set to the number of bytes scanned
+ * @return the width of the scanned bytes
+ */
+static size_t CSR_display_scan(
+  const char * str, size_t maxlen, int utf8, size_t width_max, size_t * bytes
+) {
+  unsigned const char * ustr = (unsigned const char *) str;
+  size_t n = CSR_strmlen_x(str, maxlen);
+  size_t i = 0, width = 0;
+
+  while(i < n && width < width_max) {
+    if(ustr[i] < 128 || !utf8) {
+      size_t run = utf8 ? CSR_ascii_run(ustr + i, n - i) : n - i;
+      if(run > width_max - width) run = width_max - width;
+      i += run;
+      width += run;
+      continue;
+    }
+    int byte_off = char_offset(ustr + i, 0);
+    size_t byte_len = (size_t) abs(byte_off);
+    if(byte_len > n - i) break;  // nocov, sequence cut by `maxlen`
+    size_t char_width =
+      byte_off > 0 ? (size_t) CSR_cp_width(ustr + i, byte_off) : 1;
+    if(char_width > width_max - width) break;
+    i += byte_len;
+    width += char_width;
+  }
+  // Zero width characters following the last one we fit belong with it
+
+  while(utf8 && i < n && ustr[i] >= 128) {
+    int byte_off = char_offset(ustr + i, 0);
+    if(
+      byte_off < 0 || (size_t) byte_off > n - i ||
+      CSR_cp_width(ustr + i, byte_off)
+    )
+      break;
+    i += (size_t) byte_off;
+  }
+  *bytes = i;
+  return width;
+}
+size_t CSR_display_width(const char * str, size_t maxlen, int utf8) {
+  size_t bytes;
+  return CSR_display_scan(str, maxlen, utf8, SIZE_MAX, &bytes);
+}
+/*
+ * Number of bytes of the longest prefix of `str` that fits in `width` columns
+ * without splitting a character.
+ */
+size_t CSR_display_fit(
+  const char * str, size_t width, size_t maxlen, int utf8
+) {
+  size_t bytes;
+  CSR_display_scan(str, maxlen, utf8, width, &bytes);
+  return bytes;
+}
+/*
+ * Whether the bytes of CHARSXP `chr` should be interpreted as UTF-8 by the
+ * display width functions.
+ */
+int CSR_chr_is_utf8(SEXP chr) {
+  if(TYPEOF(chr) != CHARSXP)
+    error("Internal Error: expected CHARSXP; contact maintainer."); // nocov
+  return !IS_ASCII(chr) && is_utf8_enc(getCharCE(chr), CSR_utf8_locale());
+}
+/*
+ * External version for testing; strings are converted to UTF-8 first.
+ */
+SEXP CSR_display_width_ext(SEXP string) {
+  if(TYPEOF(string) != STRSXP)
+    error("Argument `string` must be a character vector.");
+
+  R_xlen_t i, len = xlength(string);
+  SEXP res = PROTECT(allocVector(INTSXP, len));
+  int utf8_loc = CSR_utf8_locale();
+
+  for(i = 0; i < len; ++i) {
+    SEXP chr = STRING_ELT(string, i);
+    if(chr == NA_STRING) {
+      INTEGER(res)[i] = NA_INTEGER;
+      continue;
+    }
+    size_t byte_len;
+    const char * chr_utf8 =
+      (const char *) as_utf8_char(chr, utf8_loc, &byte_len);
+    size_t width = CSR_display_width(
+      chr_utf8, byte_len, getCharCE(chr) != CE_BYTES
+    );
+    INTEGER(res)[i] = width > INT_MAX ? NA_INTEGER : (int) width;
+  }
+  UNPROTECT(1);
+  return res;
+}
@@ -27,15 +27,27 @@ Go to <https://www.r-project.org/Licenses/GPL-2> for a copy of the license.
  *
  * size_init is the initial size of the content tracking character array, and
  * has no effect on the actual hash table.
+ *
+ * arena is used for the table and the content tracking, and may be NULL in
+ * which case `R_alloc` is used instead.
  */
-struct track_hash * VALC_create_track_hash(size_t size_init) {
-  pfHashTable * hash = pfHashCreate(NULL);
-  char ** contents = (char **) R_alloc(size_init, sizeof(char *));
+struct track_hash * VALC_create_track_hash(
+  size_t size_init, struct VALC_arena * arena
+) {
+  if(size_init < 1) size_init = 1;
   struct track_hash * track_hash =
-    (struct track_hash *) R_alloc(1, sizeof(struct track_hash));
-
-  track_hash->hash = hash;
-  track_hash->contents = contents;
+    (struct track_hash *) VALC_arena_alloc(arena, 1, sizeof(struct track_hash));
+
+  track_hash->arena = arena;
+  track_hash->keys = VALC_arena_init(VALC_ARENA_BLOCK_SIZE / 8);
+  track_hash->hash = pfHashCreate(NULL, arena);
+  // nodes go to the resettable arena, not to the one the table is in
+  track_hash->hash->arena = &(track_hash->keys);
+  track_hash->contents =
+    (char **) VALC_arena_alloc(arena, size_init, sizeof(char *));
+  track_hash->marks = (struct VALC_arena_mark *) VALC_arena_alloc(
+    arena, size_init, sizeof(struct VALC_arena_mark)
+  );
   track_hash->idx = 0;
   track_hash->idx_max = size_init;
 
@@ -48,7 +60,8 @@ struct track_hash * VALC_create_track_hash(size_t size_init) {
  *
  * reset_track_hash(x, 0) will remove all entries.
  *
- * Modifies the hash table by reference.
+ * Modifies the hash table by reference.  Memory used by the removed entries is
+ * released back to the key arena.
  */
 
 void VALC_reset_track_hash(
@@ -65,6 +78,8 @@ void VALC_reset_track_hash(
       );
       // nocov end
   }
+  if(idx < track_hash->idx)
+    VALC_arena_reset(&(track_hash->keys), track_hash->marks[idx]);
   track_hash->idx = idx;
 }
 /* Add an item to the hash table
@@ -80,6 +95,7 @@ int VALC_add_to_track_hash(
   size_t max_nchar
 ) {
   int res = 1;
+  struct VALC_arena_mark mark = VALC_arena_get_mark(&(track_hash->keys));
   int res_set = pfHashSet(track_hash->hash, key, value);
 
   if(res_set < 0) {
@@ -112,13 +128,15 @@ int VALC_add_to_track_hash(
         );
         // nocov end
       }
-      // re-allocate, note that we are re-allocating an array of pointers to
-      // strings, but `S_realloc` is looking for a (char *) hence the coersion
+      // re-allocate, grows in place if nothing else was allocated since
 
-      track_hash->contents = (char **) S_realloc(
-        (char *) track_hash->contents, (long) new_size,
-        (long) track_hash->idx_max,
-        sizeof(char *)
+      track_hash->contents = (char **) VALC_arena_realloc(
+        track_hash->arena, track_hash->contents, new_size,
+        track_hash->idx_max, sizeof(char *)
+      );
+      track_hash->marks = (struct VALC_arena_mark *) VALC_arena_realloc(
+        track_hash->arena, track_hash->marks, new_size,
+        track_hash->idx_max, sizeof(struct VALC_arena_mark)
       );
       res = (int) new_size;
       track_hash->idx_max = new_size;
@@ -132,8 +150,10 @@ int VALC_add_to_track_hash(
     // present for the duration of execution, but cost is probably reasonably
     // low.  Should revisit if this turns out to be wrong.
 
-    char * key_cpy = CSR_strmcpy(key, max_nchar);
+    char * key_cpy =
+      CSR_strmcpy_arena(key, max_nchar, 1, &(track_hash->keys));
     track_hash->contents[track_hash->idx] = key_cpy;
+    track_hash->marks[track_hash->idx] = mark;
     track_hash->idx++;  // shouldn't be overflowable
   }
   return res;
@@ -159,7 +179,8 @@ SEXP VALC_track_hash_test(SEXP keys, SEXP size) {
   R_xlen_t key_size = xlength(keys);
   SEXP res = PROTECT(allocVector(INTSXP, key_size));
 
-  struct track_hash * track_hash = VALC_create_track_hash(asInteger(size));
+  struct track_hash * track_hash =
+    VALC_create_track_hash(asInteger(size), NULL);
   struct VALC_settings set = VALC_settings_init();
 
   for(i = 0; i < key_size; ++i) {
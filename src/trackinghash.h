@@ -26,15 +26,23 @@ Go to <https://www.r-project.org/Licenses/GPL-2> for a copy of the license.
   /*
    * Note: last value written to `contents` is at ->idx - 1, if ->idx is zero,
    * then the list is empty
+   *
+   * Hash nodes and key copies are allocated from `keys`, which is rewound to
+   * `marks[idx]` on reset so that memory is re-used across sub-scopes.
    */
 
   struct track_hash {
     pfHashTable * hash;
     char ** contents;          // an array of characters
+    struct VALC_arena_mark * marks; // state of `keys` before each entry
+    struct VALC_arena * arena; // where `contents` and `marks` live
+    struct VALC_arena keys;    // where hash nodes and key copies live
     size_t idx;                // location after last value in contents
     size_t idx_max;            // how big the contents are
   };
-  struct track_hash * VALC_create_track_hash(size_t size_init);
+  struct track_hash * VALC_create_track_hash(
+    size_t size_init, struct VALC_arena * arena
+  );
   int VALC_add_to_track_hash(
     struct track_hash * track_hash, const char * key, const char * value,
     size_t max_nchar
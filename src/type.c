@@ -18,6 +18,32 @@ Go to <https://www.r-project.org/Licenses/GPL-2> for a copy of the license.
 
 #include "alike.h"
 
+/*
+Whether `ALIKEC_typeof_sample` checks `object` on a sample rather than in full
+*/
+static int ALIKEC_is_sampled(SEXP object, struct VALC_settings set) {
+  R_xlen_t obj_len = xlength(object);
+  return TYPEOF(object) == REALSXP && obj_len > set.elt_sample &&
+    obj_len > set.fuzzy_int_max_len;
+}
+/*
+Whether the type comparison of `target` and `current` decided integer-likeness
+on a sample, which mirrors the logic in `ALIKEC_type_alike_internal`
+*/
+static int ALIKEC_type_sampled(
+  SEXP target, SEXP current, struct VALC_settings set
+) {
+  if(
+    set.type_mode || set.elt_sample <= 0 || set.fuzzy_int_max_len < 0 ||
+    TYPEOF(target) != INTSXP || TYPEOF(current) == INTSXP
+  )
+    return 0;
+  R_xlen_t tar_len = xlength(target), cur_len = xlength(current);
+  return
+    (tar_len <= set.fuzzy_int_max_len || tar_len > set.elt_sample) &&
+    (cur_len <= set.fuzzy_int_max_len || cur_len > set.elt_sample) &&
+    (ALIKEC_is_sampled(target, set) || ALIKEC_is_sampled(current, set));
+}
 /*
 compare types, accounting for "integer like" numerics; empty string means
 success, otherwise outputs an a character string explaining why the types are
@@ -33,7 +59,7 @@ struct ALIKEC_res ALIKEC_type_alike_internal(
   tar_type_raw = TYPEOF(target);
   cur_type_raw = TYPEOF(current);
 
-  struct ALIKEC_res res = ALIKEC_res_init();
+  struct ALIKEC_res res = ALIKEC_res_init(set.arena);
 
   if(tar_type_raw == cur_type_raw) return res;
 
@@ -41,17 +67,34 @@ struct ALIKEC_res ALIKEC_type_alike_internal(
   cur_type = cur_type_raw;
 
   if(set.type_mode == 0) {
+    // With `elt.sample`, vectors too long for `fuzzy.int.max.len` can still be
+    // integer-like, but only if they are also longer than `elt.sample` so that
+    // they are checked on a sample; vectors in between are not integer-like
+    // as before.
+
+    R_xlen_t tar_len = xlength(target), cur_len = xlength(current);
+    int sample = 0;
+    if(set.elt_sample > 0 && set.fuzzy_int_max_len >= 0)
+      sample =
+        (tar_len <= set.fuzzy_int_max_len || tar_len > set.elt_sample) &&
+        (cur_len <= set.fuzzy_int_max_len || cur_len > set.elt_sample);
+
     if(
       tar_type_raw == INTSXP && (
-        set.fuzzy_int_max_len < 0 ||
+        set.fuzzy_int_max_len < 0 || sample ||
         (
-          xlength(target) <= set.fuzzy_int_max_len &&
-          xlength(current) <= set.fuzzy_int_max_len
+          tar_len <= set.fuzzy_int_max_len &&
+          cur_len <= set.fuzzy_int_max_len
       ) )
     ) {
       int_like = 1;
     }
-    if(int_like || (
+    if(int_like && sample) {
+      // Vectors too long for `fuzzy.int.max.len` are checked on a sample
+
+      tar_type = ALIKEC_typeof_sample(target, set);
+      cur_type = ALIKEC_typeof_sample(current, set);
+    } else if(int_like || (
         tar_type_raw == CLOSXP || tar_type_raw == SPECIALSXP ||
         tar_type_raw == BUILTINSXP
       )
@@ -81,8 +124,11 @@ struct ALIKEC_res ALIKEC_type_alike_internal(
   struct ALIKEC_res res_fin = res;
 
   res_fin.success = 0;
-  res_fin.dat.strings.target[0]= "type \"%s\"";
+  res_fin.dat.strings.target[0]= "type \"%s\"%s";
   res_fin.dat.strings.target[1]= what;
+  res_fin.dat.strings.target[2]=
+    int_like && ALIKEC_type_sampled(target, current, set) ?
+    " (checked on a sample)" : "";
   res_fin.dat.strings.current[0] = "\"%s\"";
   res_fin.dat.strings.current[1] = type2char(cur_type);
   res_fin.wrap = allocVector(VECSXP, 2); // note not PROTECTing b/c return
@@ -101,6 +147,10 @@ SEXP ALIKEC_type_alike(
     res_sexp = PROTECT(ALIKEC_res_as_string(res, call, set));
   } else {
     res_sexp = PROTECT(ScalarLogical(1));
+    // Mark success as sampled as `all_bw` does
+
+    if(ALIKEC_type_sampled(target, current, set))
+      setAttrib(res_sexp, install("sampled"), ScalarLogical(1));
   }
   UNPROTECT(2);
   return(res_sexp);
@@ -108,29 +158,27 @@ SEXP ALIKEC_type_alike(
 
 /* - typeof ----------------------------------------------------------------- */
 
+/*
+ * Whether all of `x[from:(to - 1)]` are integer-like
+ */
+static int ALIKEC_int_like(double * x, R_xlen_t from, R_xlen_t to) {
+  /*
+  could optimize this more by using the magic number tricks or bit
+  fiddling, but at end of day this still wouldn't be fast enough to
+  realistically use on a very large vector, so it doesn't really matter
+  */
+  for(R_xlen_t i = from; i < to; i++) {
+    if((isnan(x[i]) || !isfinite(x[i])) || x[i] != (int)x[i]) return 0;
+  }
+  return 1;
+}
 SEXPTYPE ALIKEC_typeof_internal(SEXP object) {
-  double * obj_real;
   SEXPTYPE obj_type = TYPEOF(object);
 
   switch(obj_type) {
     case REALSXP:
-      {
-        R_xlen_t obj_len = XLENGTH(object), i;
-        obj_real = REAL(object);
-        /*
-        could optimize this more by using the magic number tricks or bit
-        fiddling, but at end of day this still wouldn't be fast enough to
-        realistically use on a very large vector, so it doesn't really matter
-        */
-        for(i = 0; i < obj_len; i++) {
-          if(
-            (isnan(obj_real[i]) || !isfinite(obj_real[i])) ||
-            obj_real[i] != (int)obj_real[i]
-          )
-            return REALSXP;
-        }
-        return INTSXP;
-      }
+      return
+        ALIKEC_int_like(REAL(object), 0, XLENGTH(object)) ? INTSXP : REALSXP;
       break;
     case CLOSXP:
     case BUILTINSXP:
@@ -139,6 +187,29 @@ SEXPTYPE ALIKEC_typeof_internal(SEXP object) {
   }
   return(obj_type);
 }
+/*
+ * As `ALIKEC_typeof_internal`, but numeric vectors longer than both
+ * `set.elt_sample` and `set.fuzzy_int_max_len` are only checked on a sample of
+ * about `set.elt_sample` elements to decide whether they are integer-like.
+ */
+SEXPTYPE ALIKEC_typeof_sample(SEXP object, struct VALC_settings set) {
+  R_xlen_t obj_len = xlength(object);
+  if(
+    TYPEOF(object) != REALSXP || obj_len <= set.elt_sample ||
+    obj_len <= set.fuzzy_int_max_len
+  )
+    return ALIKEC_typeof_internal(object);
+
+  struct VALC_sample sample =
+    VALC_sample_init(obj_len, set.elt_sample, set.elt_seed, set.arena);
+  double * obj_real = REAL(object);
+  for(R_xlen_t j = 0; j < sample.n_blocks; ++j) {
+    R_xlen_t start = sample.starts[j];
+    if(!ALIKEC_int_like(obj_real, start, start + sample.block_size))
+      return REALSXP;
+  }
+  return INTSXP;
+}
 /*
 External interface for typeof, here mostly so we don't have to deal with the
 SEXP return in the internal use case
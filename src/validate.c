@@ -30,15 +30,17 @@ struct VALC_res_list VALC_res_list_init(struct VALC_settings set) {
     );
     // nocov end
 
-  struct VALC_res_node * list_start = (struct VALC_res_node *) R_alloc(
-    set.result_list_size_init, sizeof(struct VALC_res_node)
-  );
+  struct VALC_res_node * list_start =
+    (struct VALC_res_node *) VALC_arena_alloc(
+      set.arena, set.result_list_size_init, sizeof(struct VALC_res_node)
+    );
 
   struct VALC_res_list res_list = (struct VALC_res_list) {
     .idx = 0,
     .idx_alloc = set.result_list_size_init,
     .idx_alloc_max = set.result_list_size_max,
     .list_tpl = list_start,
+    .arena = set.arena,
     .list_sxp = PROTECT(list1(R_NilValue))
   };
   res_list.list_sxp_tail = res_list.list_sxp;
@@ -67,9 +69,9 @@ struct VALC_res_list VALC_res_add(
       } else {
         alloc_size = list.idx_alloc * 2;
       }
-      list.list_tpl = (struct VALC_res_node *) S_realloc(
-        (char *) list.list_tpl, (long) alloc_size,
-        (long) list.idx_alloc, sizeof(struct VALC_res_node)
+      list.list_tpl = (struct VALC_res_node *) VALC_arena_realloc(
+        list.arena, list.list_tpl, (size_t) alloc_size,
+        (size_t) list.idx_alloc, sizeof(struct VALC_res_node)
       );
       list.idx_alloc = alloc_size;
     } else {
@@ -111,13 +113,16 @@ struct VALC_res_list VALC_res_add(
  *   except the introductory part of the error message
  * - 1 = entire error message returned as character(1L)
  * - 2 = pieces of error message returned as character(N)
- * @param stop if 1 then stop, otherwise return
+ * @param stop if 1 then stop, if 2 return the message that would have been
+ *   used with stop as character(1L), otherwise return
  */
 
 SEXP VALC_process_error(
   SEXP val_res, SEXP val_tag, SEXP fun_call, int ret_mode, int stop,
   struct VALC_settings set
 ) {
+  VALC_PROF_START(prof_start);
+
   // - Failure / Validation ----------------------------------------------------
 
   // Failure, explain why; two pass process because we first need to determine
@@ -139,24 +144,16 @@ SEXP VALC_process_error(
     );
     // nocov end
 
-  if(!xlength(val_res)) return VALC_TRUE;
+  if(!xlength(val_res)) {
+    VALC_PROF_END(VALC_PROF_PROCESS_ERROR, prof_start);
+    return VALC_TRUE;
+  }
 
-  // Compose optional argument part of message. This ends up being "Argument
-  // `x` should %s" where arg and should are optional
+  // Optional argument part of message. This ends up being "For argument `x`"
+  // in full mode
 
-  char * err_arg_msg = "";
   const char * err_arg = CHAR(PRINTNAME(val_tag));
-  const char * err_very_base = "For argument `%s`%s%s%s";
 
-  if(ret_mode == 1) {
-    err_arg_msg = CSR_smprintf4(
-      set.nchar_max, err_very_base, err_arg, "", "", ""
-    );
-  }
-  const char * err_base = "%s%%s%%s%s%s%s";
-  char * err_base_msg = CSR_smprintf4(
-    set.nchar_max, err_base, err_arg_msg, "", "", ""
-  );
   // Collapse similar entries into one; from this point on every entry in the
   // list should be a character(1L)
 
@@ -174,9 +171,6 @@ SEXP VALC_process_error(
   if(has_header) {
     SET_STRING_ELT(err_vec_res, 0, mkChar(""));  // will add header later
   }
-  SEXP bullet = PROTECT(mkChar("  - "));
-  SEXP ctd = PROTECT(mkChar("    "));
-
   for(i = 0; i < err_len; i++) {
     SEXP str = VECTOR_ELT(err_msg_c, i);
     if(TYPEOF(str) != STRSXP || XLENGTH(str) != 1L) {
@@ -191,9 +185,10 @@ SEXP VALC_process_error(
     SEXP old_elt = STRING_ELT(str, 0);
 
     if(err_len > 1 && ret_mode != 2) {
-      new_elt = PROTECT(
-        mkChar(CSR_bullet(old_elt, bullet, ctd, set.nchar_max))
-      );
+      struct CSR_strbuf err_bullet =
+        CSR_strbuf_init(set.nchar_max, set.arena);
+      CSR_strbuf_add_bullet(&err_bullet, CHAR(old_elt), "  - ", "    ");
+      new_elt = PROTECT(mkChar(err_bullet.str));
     } else {
       new_elt = PROTECT(old_elt);
     }
@@ -204,42 +199,43 @@ SEXP VALC_process_error(
     // In this case we return the actual vector, in all others we need to
     // generate the string; this is handled by the !stop bit further down
   } else {
+    struct CSR_strbuf err_head = CSR_strbuf_init(set.nchar_max, set.arena);
+    if(ret_mode == 1)
+      CSR_strbuf_addf(&err_head, "For argument `%s`", err_arg);
+
     if(err_len == 1) {
       // Here we need to compose the full character value since there is only
       // one correct value for the arg
 
-      const char * err_msg_orig = CHAR(asChar(err_vec_res));
-      char * err_msg = CSR_strmcpy(err_msg_orig, set.nchar_max);
-      if(err_msg) err_msg[0] = tolower(err_msg[0]);
+      if(ret_mode == 1) CSR_strbuf_add(&err_head, ", ");
+      size_t err_msg_start = err_head.len;
+      CSR_strbuf_add(&err_head, CHAR(asChar(err_vec_res)));
+      if(err_head.len > err_msg_start)
+        err_head.str[err_msg_start] = tolower(err_head.str[err_msg_start]);
 
-      const char * err_interim = "";
-      if(ret_mode == 1) err_interim = ", ";
-
-      char * err_full = CSR_smprintf4(
-        set.nchar_max, err_base_msg, err_interim, err_msg, "", ""
-      );
-      SET_STRING_ELT(err_vec_res, 0, mkChar(err_full));
+      SET_STRING_ELT(err_vec_res, 0, mkChar(err_head.str));
     } else if(has_header) {
       // Have multiple "or" cases
 
-      const char * err_interim = "";
       if(ret_mode == 1) {
-        err_interim = " at least one of these should pass:";
+        CSR_strbuf_add(&err_head, " at least one of these should pass:");
       } else if(!ret_mode) {
-        err_interim = "At least one of these should pass:";
+        CSR_strbuf_add(&err_head, "At least one of these should pass:");
       }
-      char * err_head = CSR_smprintf4(
-        set.nchar_max, err_base_msg, err_interim, "", "", ""
-      );
-      SET_STRING_ELT(err_vec_res, 0, mkChar(err_head));
+      SET_STRING_ELT(err_vec_res, 0, mkChar(err_head.str));
     }
   }
-  UNPROTECT(4);  // unprotects vector result
   if(!stop) {
+    UNPROTECT(2);  // unprotects vector result
+    VALC_PROF_END(VALC_PROF_PROCESS_ERROR, prof_start);
     return err_vec_res;
   } else {
-    char * err_full = CSR_collapse(err_vec_res, "\n", set.nchar_max);
-    VALC_stop(fun_call, err_full);
+    struct CSR_strbuf err_full = CSR_strbuf_init(set.nchar_max, set.arena);
+    CSR_strbuf_add_joined(&err_full, err_vec_res, "\n");
+    UNPROTECT(2);
+    VALC_PROF_END(VALC_PROF_PROCESS_ERROR, prof_start);
+    if(stop == 2) return mkString(err_full.str);
+    VALC_stop(fun_call, err_full.str);
   }
   // nocov start
   error("%s",
@@ -247,6 +243,106 @@ SEXP VALC_process_error(
   );
   // nocov end
 }
+/*
+ * The message `VALC_process_error` would signal for a result of
+ * `VALC_evaluate`
+ */
+SEXP VALC_fail_message(
+  SEXP fail, SEXP val_tag, SEXP fun_call, int ret_mode,
+  struct VALC_settings set
+) {
+  SEXP val_res = PROTECT(VALC_fail_render(fail, set));
+  SEXP res = VALC_process_error(val_res, val_tag, fun_call, ret_mode, 2, set);
+  UNPROTECT(1);
+  return res;
+}
+/*
+ * Message for the data carried by a "vetr_error" condition, see
+ * `VALC_fail_signal`.
+ */
+static SEXP VALC_cond_render(SEXP dat, SEXP call) {
+  struct VALC_settings set =
+    VALC_settings_vet(VECTOR_ELT(dat, 3), R_BaseEnv);
+  struct VALC_arena arena = VALC_arena_init(VALC_ARENA_BLOCK_SIZE);
+  set.arena = &arena;
+  int width_opt = -1;
+  set.width_opt = &width_opt;
+
+  SEXP res = PROTECT(
+    VALC_fail_message(
+      VECTOR_ELT(dat, 0), VECTOR_ELT(dat, 1), call,
+      asInteger(VECTOR_ELT(dat, 2)), set
+  ) );
+  VALC_arena_close(&arena);
+  UNPROTECT(1);
+  return res;
+}
+/*
+ * Signal a failure as a "vetr_error" condition.
+ *
+ * Failures are often caught and discarded, so instead of a message the
+ * condition carries the result of `VALC_evaluate` and what else is needed to
+ * produce the message, which is only done if requested via `conditionMessage`.
+ * `stop` asks for the message before signaling, so we first signal the
+ * condition with `signalCondition`, and only if no handler exits do we render
+ * the message and `stop` with a plain "simpleError".  Handlers for
+ * "vetr_error" thus see each failure once, and exiting handlers never cause
+ * the message to be rendered.
+ *
+ * Arguments are as for `VALC_audit_add`.  The arena must be closed by the
+ * caller beforehand as we may not return.
+ */
+static void VALC_fail_signal(
+  SEXP fail, SEXP val_tag, SEXP fun_call, int ret_mode, SEXP settings
+) {
+  SEXP cond = PROTECT(allocVector(VECSXP, 2));
+  SEXP cond_names = PROTECT(allocVector(STRSXP, 2));
+  SET_STRING_ELT(cond_names, 0, mkChar("call"));
+  SET_STRING_ELT(cond_names, 1, mkChar("vetr"));
+  setAttrib(cond, R_NamesSymbol, cond_names);
+  SEXP cond_class = PROTECT(allocVector(STRSXP, 3));
+  SET_STRING_ELT(cond_class, 0, mkChar("vetr_error"));
+  SET_STRING_ELT(cond_class, 1, mkChar("error"));
+  SET_STRING_ELT(cond_class, 2, mkChar("condition"));
+  setAttrib(cond, R_ClassSymbol, cond_class);
+
+  SEXP dat = PROTECT(allocVector(VECSXP, 4));
+  SET_VECTOR_ELT(dat, 0, fail);
+  SET_VECTOR_ELT(dat, 1, val_tag);
+  SET_VECTOR_ELT(dat, 2, ScalarInteger(ret_mode));
+  SET_VECTOR_ELT(dat, 3, settings);
+  SET_VECTOR_ELT(cond, 0, fun_call);
+  SET_VECTOR_ELT(cond, 1, dat);
+
+  SEXP quot_call = PROTECT(lang2(VALC_SYM_quote, fun_call));
+  SEXP sig_call = PROTECT(
+    lang4(
+      install("signalCondition"), cond, mkString("vetr validation failure"),
+      quot_call
+  ) );
+  eval(sig_call, R_BaseEnv);
+
+  // No handler exited
+
+  SEXP msg = PROTECT(VALC_cond_render(dat, fun_call));
+  VALC_stop(fun_call, CHAR(STRING_ELT(msg, 0)));
+  // nocov start
+  error("Internal Error: should never get here 2488; contact maintainer");
+  // nocov end
+}
+/*
+ * Message for a "vetr_error" condition, for `conditionMessage`
+ */
+SEXP VALC_cond_message(SEXP cond) {
+  SEXP dat;
+  if(
+    TYPEOF(cond) != VECSXP || XLENGTH(cond) != 2 ||
+    TYPEOF(dat = VECTOR_ELT(cond, 1)) != VECSXP || XLENGTH(dat) != 4
+  )
+    error("Argument `cond` is not a valid \"vetr_error\" condition.");
+
+  return VALC_cond_render(dat, VECTOR_ELT(cond, 0));
+}
 /* -------------------------------------------------------------------------- *\
 \* -------------------------------------------------------------------------- */
 
@@ -272,6 +368,11 @@ SEXP VALC_validate(
     );
 
   struct VALC_settings set = VALC_settings_vet(settings, rho);
+  struct VALC_arena arena = VALC_arena_init(VALC_ARENA_BLOCK_SIZE);
+  set.arena = &arena;
+  int width_opt = -1;
+  set.width_opt = &width_opt;
+
   res = PROTECT(
     VALC_evaluate(
       target, cur_sub,
@@ -279,7 +380,8 @@ SEXP VALC_validate(
       current, par_call, set, 1
     )
   );
-  if(!xlength(res)) {
+  if(res == R_NilValue) {
+    VALC_arena_close(&arena);
     UNPROTECT(1);
     return(ScalarLogical(1));
   }
@@ -299,9 +401,21 @@ SEXP VALC_validate(
       "\"full\""
     );
 
-  SEXP out = VALC_process_error(
-    res, VALC_SYM_current, par_call, ret_mode, stop_int, set
-  );
+  SEXP out = R_NilValue;
+  if(stop_int && set.audit) {
+    VALC_audit_add(res, VALC_SYM_current, par_call, ret_mode, settings);
+    out = ScalarLogical(0);
+  } else if(stop_int) {
+    VALC_arena_close(&arena);
+    VALC_fail_signal(res, VALC_SYM_current, par_call, ret_mode, settings);
+  } else {
+    SEXP val_res = PROTECT(VALC_fail_render(res, set));
+    out = VALC_process_error(
+      val_res, VALC_SYM_current, par_call, ret_mode, 0, set
+    );
+    UNPROTECT(1);
+  }
+  VALC_arena_close(&arena);
   UNPROTECT(1);
   return out;
 }
@@ -309,13 +423,78 @@ SEXP VALC_validate(
 /* -------------------------------------------------------------------------- *\
 \* -------------------------------------------------------------------------- */
 
-SEXP VALC_validate_args(
-  SEXP fun, SEXP fun_call, SEXP val_call, SEXP fun_frame, SEXP settings
-) {
-  // For now just use default settings
+/*
+ * Calls `vetr` evaluates in its own frame to retrieve the function frame, and
+ * the matched function and validation calls.  These are the same as the
+ * `.Call` arguments `vetr` used to compute, but are now only evaluated once we
+ * know the call is going to be validated.
+ */
+static SEXP VALC_LANG_fun_frame = NULL;
+static SEXP VALC_LANG_fun_call;
+static SEXP VALC_LANG_val_call;
+
+static void VALC_validate_args_init(void) {
+  SEXP sys_par = PROTECT(lang2(install("sys.parent"), ScalarInteger(1)));
+  SEXP sys_fun = PROTECT(lang2(install("sys.function"), sys_par));
+  SEXP sys_call = PROTECT(lang2(install("sys.call"), sys_par));
+  SEXP par_frame_2 =
+    PROTECT(lang2(install("parent.frame"), ScalarInteger(2)));
+
+  // parent.frame()
+
+  VALC_LANG_fun_frame = lang1(install("parent.frame"));
+  R_PreserveObject(VALC_LANG_fun_frame);
+
+  // match.call(
+  //   definition=sys.function(sys.parent(1)),
+  //   call=sys.call(sys.parent(1)), envir=parent.frame(2)
+  // )
+
+  VALC_LANG_fun_call =
+    lang4(ALIKEC_SYM_matchcall, sys_fun, sys_call, par_frame_2);
+  R_PreserveObject(VALC_LANG_fun_call);
+  SET_TAG(CDR(VALC_LANG_fun_call), install("definition"));
+  SET_TAG(CDDR(VALC_LANG_fun_call), install("call"));
+  SET_TAG(CDR(CDDR(VALC_LANG_fun_call)), install("envir"));
+
+  // match.call(definition=sys.function(sys.parent(1)), envir=parent.frame())
+
+  VALC_LANG_val_call =
+    lang3(ALIKEC_SYM_matchcall, sys_fun, VALC_LANG_fun_frame);
+  R_PreserveObject(VALC_LANG_val_call);
+  SET_TAG(CDR(VALC_LANG_val_call), install("definition"));
+  SET_TAG(CDDR(VALC_LANG_val_call), install("envir"));
+
+  UNPROTECT(4);
+}
+/*
+ * @param fun the function whose arguments are being validated
+ * @param settings the `.VETR_SETTINGS` argument to `vetr`
+ * @param rho the `vetr` frame
+ */
+SEXP VALC_validate_args(SEXP fun, SEXP settings, SEXP rho) {
+  // Decide whether to validate before doing anything else, and in particular
+  // before the `match.call`s, so skipped calls cost little more than a counter
+  // increment
+
+  int vetr_sample, stats_sample;
+  VALC_settings_sampling(settings, &vetr_sample, &stats_sample);
+  struct VALC_stats_call stats =
+    VALC_stats_start(fun, vetr_sample, stats_sample);
+  if(stats.skip) return VALC_TRUE;
+
+  if(!VALC_LANG_fun_frame) VALC_validate_args_init();
+  SEXP fun_call = PROTECT(eval(VALC_LANG_fun_call, rho));
+  SEXP val_call = PROTECT(eval(VALC_LANG_val_call, rho));
+  SEXP fun_frame = PROTECT(eval(VALC_LANG_fun_frame, rho));
 
   struct VALC_settings set = VALC_settings_vet(settings, fun_frame);
   set.env = fun_frame;
+  struct VALC_arena arena = VALC_arena_init(VALC_ARENA_BLOCK_SIZE);
+  set.arena = &arena;
+  int width_opt = -1;
+  set.width_opt = &width_opt;
+  VALC_stats_label(stats, fun_call, set);
 
   // For the elements with validation call setup, check for errors;  Note that
   // we need to skip the first element of the calls since we only care about the
@@ -398,6 +577,7 @@ SEXP VALC_validate_args(
         arg_tag = frm_tag;
         fun_tok = CAR(fun_form_cpy);
       } else {
+        VALC_arena_close(&arena);
         VALC_arg_error(
           frm_tag, fun_call, "argument `%s` is missing, with no default"
         );
@@ -434,6 +614,7 @@ SEXP VALC_validate_args(
 
     SEXP fun_val = R_tryEval(arg_tag, fun_frame, err_point);
     if(* err_point) {
+      VALC_arena_close(&arena);
       VALC_arg_error(
         arg_tag, fun_call,
         "Argument `%s` produced error during evaluation; see previous error."
@@ -443,10 +624,18 @@ SEXP VALC_validate_args(
     SEXP val_res = PROTECT(
       VALC_evaluate(val_tok, fun_tok, arg_tag, fun_val, val_call, set, 0)
     );
-    if(xlength(val_res)) {
+    if(val_res != R_NilValue) {
       // fail, produce error message: NOTE - might change if we try to use full
       // expression instead of just arg name
-      VALC_process_error(val_res, arg_tag, fun_call, 1, 1, set);
+      VALC_stats_end(stats, 1);
+      if(set.audit) {
+        VALC_audit_add(val_res, arg_tag, fun_call, 1, settings);
+        VALC_arena_close(&arena);
+        UNPROTECT(4);
+        return ScalarLogical(0);
+      }
+      VALC_arena_close(&arena);
+      VALC_fail_signal(val_res, arg_tag, fun_call, 1, settings);
       // nocov start
       error("Internal Error: should never get here 2487; contact maintainer");
       // nocov end
@@ -461,5 +650,8 @@ SEXP VALC_validate_args(
     );
     // nocov end
   }
+  VALC_arena_close(&arena);
+  VALC_stats_end(stats, 0);
+  UNPROTECT(3);
   return VALC_TRUE;
 }
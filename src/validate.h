@@ -75,6 +75,8 @@ Go to <https://www.r-project.org/Licenses/GPL-2> for a copy of the license.
     int idx;
     int idx_alloc;    // how many we've allocated memory for
     int idx_alloc_max;// max we are allowed to allocate
+
+    struct VALC_arena * arena; // where `list_tpl` lives, NULL for R_alloc
   };
 
   extern SEXP VALC_SYM_one_dot;
@@ -85,11 +87,33 @@ Go to <https://www.r-project.org/Licenses/GPL-2> for a copy of the license.
   extern SEXP VALC_TRUE;
   extern SEXP VALC_SYM_errmsg;
 
+  // Per call site statistics, see stats.c
+
+  struct VALC_stats_call {
+    int slot;       // -1 if not recording
+    int skip;       // whether this call should not be validated
+    int sampled;    // whether this call is being timed
+    uint64_t start;
+  };
+
   SEXP VALC_test1(SEXP a);
   SEXP VALC_test2(SEXP a, SEXP b);
   SEXP VALC_test3(SEXP a, SEXP b, SEXP c);
 
   SEXP VALC_check_assumptions();
+  SEXP VALC_bench_time(SEXP expr, SEXP rho, SEXP times, SEXP warmup);
+  struct VALC_stats_call VALC_stats_start(
+    SEXP fun, int vetr_sample, int stats_sample
+  );
+  void VALC_stats_label(
+    struct VALC_stats_call call, SEXP fun_call, struct VALC_settings set
+  );
+  void VALC_stats_end(struct VALC_stats_call call, int fail);
+  SEXP VALC_stats(SEXP reset);
+  void VALC_audit_add(
+    SEXP val_res, SEXP val_tag, SEXP fun_call, int ret_mode, SEXP settings
+  );
+  SEXP VALC_audit(SEXP reset);
 
   SEXP VALC_res_init();
   struct VALC_res_list VALC_res_add(
@@ -101,9 +125,16 @@ Go to <https://www.r-project.org/Licenses/GPL-2> for a copy of the license.
     SEXP target, SEXP current, SEXP cur_sub, SEXP par_call, SEXP rho,
     SEXP ret_mode_sxp, SEXP stop, SEXP settings
   );
-  SEXP VALC_validate_args(
-    SEXP fun, SEXP fun_call, SEXP val_call, SEXP fun_frame, SEXP settings
+  SEXP VALC_validate_args(SEXP fun, SEXP settings, SEXP rho);
+  SEXP VALC_process_error(
+    SEXP val_res, SEXP val_tag, SEXP fun_call, int ret_mode, int stop,
+    struct VALC_settings set
+  );
+  SEXP VALC_fail_message(
+    SEXP fail, SEXP val_tag, SEXP fun_call, int ret_mode,
+    struct VALC_settings set
   );
+  SEXP VALC_cond_message(SEXP cond);
   SEXP VALC_remove_parens(SEXP lang);
   SEXP VALC_name_sub_ext(SEXP symb, SEXP arg_name);
   void VALC_stop(SEXP call, const char * msg);
@@ -132,6 +163,7 @@ Go to <https://www.r-project.org/Licenses/GPL-2> for a copy of the license.
     SEXP lang, SEXP arg_lang, SEXP arg_tag, SEXP arg_value, SEXP lang_full,
     struct VALC_settings set, int use_lang_raw
   );
+  SEXP VALC_fail_render(SEXP fail, struct VALC_settings set);
   SEXP VALC_evaluate_ext(
     SEXP lang, SEXP arg_lang, SEXP arg_tag, SEXP arg_value, SEXP lang_full,
     SEXP rho